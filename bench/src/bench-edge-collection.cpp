@@ -0,0 +1,165 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <glm/glm.hpp>
+#include <iostream>
+#include <unordered_map>
+#include <unordered_set>
+#include "bench-edge-collection.hpp"
+#include "hash.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "time-delta.hpp"
+#include "tool/sculpt/util/edge-collection.hpp"
+
+namespace
+{
+  constexpr unsigned int numIterations = 20;
+
+  ui_pair makeKey (unsigned int i1, unsigned int i2)
+  {
+    return ui_pair (glm::min (i1, i2), glm::max (i1, i2));
+  }
+
+  // probes every face edge like `splitEdges` and `triangulate` do
+  template <typename Map, typename Contains, typename Insert, typename Find>
+  unsigned int probeMap (const Mesh& mesh, Map& map, const Contains& contains,
+                         const Insert& insert, const Find& find)
+  {
+    unsigned int sum = 0;
+
+    for (unsigned int n = 0; n < numIterations; n++)
+    {
+      map.reset ();
+
+      for (unsigned int i = 0; i < mesh.numIndices (); i += 3)
+      {
+        const unsigned int i1 = mesh.index (i + 0);
+        const unsigned int i2 = mesh.index (i + 1);
+        const unsigned int i3 = mesh.index (i + 2);
+
+        if (contains (map, i1, i2) == false)
+        {
+          insert (map, i1, i2, i);
+        }
+        if (contains (map, i1, i3) == false)
+        {
+          insert (map, i1, i3, i);
+        }
+        if (contains (map, i2, i3) == false)
+        {
+          insert (map, i2, i3, i);
+        }
+      }
+      for (unsigned int i = 0; i < mesh.numIndices (); i += 3)
+      {
+        sum += find (map, mesh.index (i + 0), mesh.index (i + 1));
+        sum += find (map, mesh.index (i + 0), mesh.index (i + 2));
+        sum += find (map, mesh.index (i + 1), mesh.index (i + 2));
+      }
+    }
+    return sum;
+  }
+
+  struct NodeMap
+  {
+    std::unordered_map<ui_pair, unsigned int> map;
+
+    void reset () { this->map.clear (); }
+  };
+
+  unsigned int benchTableMap (const Mesh& mesh)
+  {
+    ToolSculptEdgeMap map;
+
+    return probeMap (
+      mesh, map,
+      [](const ToolSculptEdgeMap& m, unsigned int i1, unsigned int i2) {
+        return m.contains (i1, i2);
+      },
+      [](ToolSculptEdgeMap& m, unsigned int i1, unsigned int i2, unsigned int v) {
+        m.insert (i1, i2, v);
+      },
+      [](const ToolSculptEdgeMap& m, unsigned int i1, unsigned int i2) { return m.find (i1, i2); });
+  }
+
+  unsigned int benchNodeMap (const Mesh& mesh)
+  {
+    NodeMap map;
+
+    return probeMap (
+      mesh, map,
+      [](const NodeMap& m, unsigned int i1, unsigned int i2) {
+        return m.map.find (makeKey (i1, i2)) != m.map.end ();
+      },
+      [](NodeMap& m, unsigned int i1, unsigned int i2, unsigned int v) {
+        m.map.emplace (makeKey (i1, i2), v);
+      },
+      [](const NodeMap& m, unsigned int i1, unsigned int i2) {
+        return m.map.find (makeKey (i1, i2))->second;
+      });
+  }
+
+  unsigned int benchTableSet (const Mesh& mesh)
+  {
+    ToolSculptEdgeSet set;
+    unsigned int      sum = 0;
+
+    for (unsigned int n = 0; n < numIterations; n++)
+    {
+      set.reset ();
+
+      for (unsigned int i = 0; i < mesh.numIndices (); i += 3)
+      {
+        set.insert (mesh.index (i + 0), mesh.index (i + 1));
+        set.insert (mesh.index (i + 1), mesh.index (i + 2));
+        set.insert (mesh.index (i + 2), mesh.index (i + 0));
+      }
+      for (const ui_pair& edge : set)
+      {
+        sum += edge.first;
+      }
+    }
+    return sum;
+  }
+
+  unsigned int benchNodeSet (const Mesh& mesh)
+  {
+    std::unordered_set<ui_pair> set;
+    unsigned int                sum = 0;
+
+    for (unsigned int n = 0; n < numIterations; n++)
+    {
+      set.clear ();
+
+      for (unsigned int i = 0; i < mesh.numIndices (); i += 3)
+      {
+        set.emplace (makeKey (mesh.index (i + 0), mesh.index (i + 1)));
+        set.emplace (makeKey (mesh.index (i + 1), mesh.index (i + 2)));
+        set.emplace (makeKey (mesh.index (i + 2), mesh.index (i + 0)));
+      }
+      for (const ui_pair& edge : set)
+      {
+        sum += edge.first;
+      }
+    }
+    return sum;
+  }
+}
+
+void BenchEdgeCollection::bench ()
+{
+  const Mesh   mesh = MeshUtil::icosphere (6);
+  unsigned int tableMap, nodeMap, tableSet, nodeSet;
+
+  TIME_DELTA (tableMap = benchTableMap (mesh))
+  TIME_DELTA (nodeMap = benchNodeMap (mesh))
+  TIME_DELTA (tableSet = benchTableSet (mesh))
+  TIME_DELTA (nodeSet = benchNodeSet (mesh))
+
+  if (tableMap != nodeMap || tableSet != nodeSet)
+  {
+    std::cout << "edge collections differ\n";
+  }
+}
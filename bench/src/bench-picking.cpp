@@ -0,0 +1,119 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <glm/glm.hpp>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "bench-picking.hpp"
+#include "dynamic/octree.hpp"
+#include "intersection.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "primitive/ray.hpp"
+#include "primitive/triangle.hpp"
+#include "time-delta.hpp"
+#include "util.hpp"
+
+namespace
+{
+  constexpr unsigned int numRays = 100000;
+
+  struct Statistics
+  {
+    unsigned int numHits;
+    unsigned int numVisitedNodes;
+    unsigned int numTriangleTests;
+  };
+
+  PrimTriangle triangle (const Mesh& mesh, unsigned int i)
+  {
+    return PrimTriangle (mesh.vertex (mesh.index ((3 * i) + 0)),
+                         mesh.vertex (mesh.index ((3 * i) + 1)),
+                         mesh.vertex (mesh.index ((3 * i) + 2)));
+  }
+
+  // rays from a surrounding sphere towards random points near the mesh's center
+  std::vector<PrimRay> randomRays ()
+  {
+    std::default_random_engine            gen;
+    std::uniform_real_distribution<float> unitD (-1.0f, 1.0f);
+    std::vector<PrimRay>                  rays;
+
+    const auto randomDirection = [&gen, &unitD]() {
+      glm::vec3 d;
+      do
+      {
+        d = glm::vec3 (unitD (gen), unitD (gen), unitD (gen));
+      } while (glm::dot (d, d) > 1.0f || glm::dot (d, d) < Util::epsilon ());
+
+      return glm::normalize (d);
+    };
+
+    rays.reserve (numRays);
+    for (unsigned int i = 0; i < numRays; i++)
+    {
+      const glm::vec3 origin = 3.0f * randomDirection ();
+      const glm::vec3 target = 0.5f * randomDirection ();
+
+      rays.emplace_back (origin, glm::normalize (target - origin));
+    }
+    return rays;
+  }
+
+  Statistics pick (const DynamicOctree& octree, const Mesh& mesh, const std::vector<PrimRay>& rays)
+  {
+    Statistics stats{0, 0, 0};
+
+    for (const PrimRay& ray : rays)
+    {
+      float distance = Util::maxFloat ();
+
+      octree.intersects (ray,
+                         [&mesh, &ray, &stats, &distance](unsigned int i) {
+                           float t;
+                           stats.numTriangleTests++;
+
+                           if (IntersectionUtil::intersects (ray, triangle (mesh, i), false, &t))
+                           {
+                             distance = glm::min (distance, t);
+                           }
+                           return distance;
+                         },
+                         &stats.numVisitedNodes);
+
+      if (distance != Util::maxFloat ())
+      {
+        stats.numHits++;
+      }
+    }
+    return stats;
+  }
+}
+
+void BenchPicking::bench ()
+{
+  const Mesh                 mesh = MeshUtil::icosphere (7);
+  const std::vector<PrimRay> rays = randomRays ();
+  DynamicOctree              octree;
+  Statistics                 stats;
+
+  for (unsigned int i = 0; i < mesh.numIndices () / 3; i++)
+  {
+    const PrimTriangle tri = triangle (mesh, i);
+
+    if (octree.hasRoot () == false)
+    {
+      octree.setupRoot (tri.center (), tri.maxDimExtent ());
+    }
+    octree.addElement (i, tri.center (), tri.maxDimExtent ());
+  }
+
+  TIME_DELTA (stats = pick (octree, mesh, rays))
+
+  std::cout << "picking " << (mesh.numIndices () / 3) << " faces with " << numRays
+            << " rays: " << stats.numHits << " hits, "
+            << (float(stats.numVisitedNodes) / float(numRays)) << " visited nodes per ray, "
+            << (float(stats.numTriangleTests) / float(numRays)) << " triangle tests per ray\n";
+}
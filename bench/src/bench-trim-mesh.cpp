@@ -0,0 +1,75 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <glm/glm.hpp>
+#include <iostream>
+#include "bench-trim-mesh.hpp"
+#include "dynamic/mesh.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "primitive/ray.hpp"
+#include "time-delta.hpp"
+#include "tool/trim-mesh/action.hpp"
+#include "tool/trim-mesh/border.hpp"
+#include "tool/trim-mesh/split-mesh.hpp"
+
+namespace
+{
+  constexpr unsigned int numStrokes = 5;
+
+  // without buffering the mesh's data, which requires an OpenGL context
+  void icosphere (DynamicMesh& mesh, unsigned int numSubdivisions)
+  {
+    const Mesh icosphere = MeshUtil::icosphere (numSubdivisions);
+
+    for (unsigned int i = 0; i < icosphere.numVertices (); i++)
+    {
+      mesh.addVertex (icosphere.vertex (i), icosphere.normal (i));
+    }
+    for (unsigned int i = 0; i < icosphere.numIndices (); i += 3)
+    {
+      mesh.addFace (icosphere.index (i), icosphere.index (i + 1), icosphere.index (i + 2));
+    }
+    mesh.setAllNormals ();
+  }
+
+  /* Each stroke spans the whole mesh and cuts off everything above it, i.e. its border is a long
+   * polyline around the mesh and its hole is filled by a large cap.
+   */
+  unsigned int trim (DynamicMesh& mesh)
+  {
+    unsigned int numTrimmed = 0;
+
+    for (unsigned int i = 0; i < numStrokes; i++)
+    {
+      const float        height = 0.5f - (0.2f * float(i));
+      const glm::vec3    origin (0.01f, height, 5.0f);
+      const PrimRay      ray1 (origin, glm::vec3 (-3.0f, height + 0.05f, 0.0f) - origin);
+      const PrimRay      ray2 (origin, glm::vec3 (3.0f, height + 0.02f, 0.0f) - origin);
+      ToolTrimMeshBorder border (mesh, ray1, ray2);
+
+      if (ToolTrimMeshSplitMesh::splitMesh (border) && border.hasVertices () &&
+          ToolTrimMeshAction::trimAndFillHole (border))
+      {
+        numTrimmed++;
+      }
+    }
+    return numTrimmed;
+  }
+}
+
+void BenchTrimMesh::bench ()
+{
+  DynamicMesh mesh;
+  icosphere (mesh, 7);
+
+  const unsigned int numFaces = mesh.numFaces ();
+  unsigned int       numTrimmed;
+
+  TIME_DELTA (numTrimmed = trim (mesh))
+
+  std::cout << "trimming " << numFaces << " faces with " << numStrokes
+            << " strokes: " << numTrimmed << " trimmed, " << mesh.numFaces ()
+            << " faces left\n";
+}
@@ -0,0 +1,20 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <QCoreApplication>
+#include "bench-edge-collection.hpp"
+#include "bench-picking.hpp"
+#include "bench-trim-mesh.hpp"
+#include "time-delta.hpp"
+
+int main ()
+{
+  QCoreApplication::setApplicationName ("dilay");
+  TimeDelta::initialize ();
+
+  BenchEdgeCollection::bench ();
+  BenchPicking::bench ();
+  BenchTrimMesh::bench ();
+  return 0;
+}
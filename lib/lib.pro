@@ -7,13 +7,16 @@ INCLUDEPATH += src
 CONFIG      += staticlib
 
 SOURCES += \
+           src/bvh.cpp \
            src/camera.cpp \
            src/color.cpp \
            src/config.cpp \
            src/configurable.cpp \
            src/dimension.cpp \
            src/distance.cpp \
+           src/dynamic/chunks.cpp \
            src/dynamic/faces.cpp \
+           src/dynamic/lod.cpp \
            src/dynamic/mesh.cpp \
            src/dynamic/mesh-intersection.cpp \
            src/dynamic/octree.cpp \
@@ -33,10 +36,12 @@ SOURCES += \
            src/primitive/cone.cpp \
            src/primitive/cone-sphere.cpp \
            src/primitive/cylinder.cpp \
+           src/primitive/frustum.cpp \
            src/primitive/plane.cpp \
            src/primitive/ray.cpp \
            src/primitive/sphere.cpp \
            src/primitive/triangle.cpp \
+           src/primitive/triangle-packet.cpp \
            src/render-mode.cpp \
            src/renderer.cpp \
            src/scene.cpp \
@@ -94,6 +99,7 @@ SOURCES += \
            src/view/log.cpp \
            src/view/main-window.cpp \
            src/view/menu-bar.cpp \
+           src/view/pick-buffer.cpp \
            src/view/pointing-event.cpp \
            src/view/resolution-slider.cpp \
            src/view/shortcut.cpp \
@@ -106,6 +112,7 @@ SOURCES += \
 
 HEADERS += \
            src/bitset.hpp \
+           src/bvh.hpp \
            src/cache.hpp \
            src/camera.hpp \
            src/color.hpp \
@@ -113,7 +120,9 @@ HEADERS += \
            src/configurable.hpp \
            src/dimension.hpp \
            src/distance.hpp \
+           src/dynamic/chunks.hpp \
            src/dynamic/faces.hpp \
+           src/dynamic/lod.hpp \
            src/dynamic/mesh.hpp \
            src/dynamic/mesh-intersection.hpp \
            src/dynamic/octree.hpp \
@@ -136,10 +145,12 @@ HEADERS += \
            src/primitive/cone.hpp \
            src/primitive/cone-sphere.hpp \
            src/primitive/cylinder.hpp \
+           src/primitive/frustum.hpp \
            src/primitive/plane.hpp \
            src/primitive/ray.hpp \
            src/primitive/sphere.hpp \
            src/primitive/triangle.hpp \
+           src/primitive/triangle-packet.hpp \
            src/render-mode.hpp \
            src/renderer.hpp \
            src/scene.hpp \
@@ -186,6 +197,7 @@ HEADERS += \
            src/view/log.hpp \
            src/view/main-window.hpp \
            src/view/menu-bar.hpp \
+           src/view/pick-buffer.hpp \
            src/view/pointing-event.hpp \
            src/view/resolution-slider.hpp \
            src/view/shortcut.hpp \
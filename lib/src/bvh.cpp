@@ -0,0 +1,255 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <vector>
+#include "bvh.hpp"
+#include "intersection.hpp"
+#include "primitive/aabox.hpp"
+#include "primitive/ray.hpp"
+#include "util.hpp"
+
+namespace
+{
+  constexpr unsigned int maxElementsPerLeaf = 2;
+
+  struct Box
+  {
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+
+    void extend (const Box& other)
+    {
+      this->minimum = glm::min (this->minimum, other.minimum);
+      this->maximum = glm::max (this->maximum, other.maximum);
+    }
+
+    bool intersects (const PrimRay& ray, float& t) const
+    {
+      return IntersectionUtil::intersects (ray, PrimAABox (this->minimum, this->maximum), &t);
+    }
+
+    bool contains (const glm::vec3& p) const
+    {
+      return glm::all (glm::lessThanEqual (this->minimum, p)) &&
+             glm::all (glm::lessThanEqual (p, this->maximum));
+    }
+  };
+
+  // the children of an inner node are stored consecutively, starting at `first`.
+  // The elements of a leaf are stored consecutively in `BVH::Impl::elements`, starting at `first`.
+  struct Node
+  {
+    Box          box;
+    unsigned int first;
+    unsigned int numElements;
+
+    bool isLeaf () const { return this->numElements > 0; }
+  };
+
+  struct QueueItem
+  {
+    float        distance;
+    unsigned int node;
+
+    bool operator< (const QueueItem& other) const { return this->distance > other.distance; }
+  };
+}
+
+struct BVH::Impl
+{
+  std::vector<Node>         nodes;
+  std::vector<unsigned int> elements;
+  std::vector<Box>          boxes;
+
+  unsigned int numElements () const { return this->elements.size (); }
+
+  void build (unsigned int n, const BoundsCallback& getBounds)
+  {
+    this->reset ();
+
+    if (n > 0)
+    {
+      this->elements.resize (n);
+      this->boxes.resize (n);
+
+      for (unsigned int i = 0; i < n; i++)
+      {
+        this->elements[i] = i;
+        getBounds (i, this->boxes[i].minimum, this->boxes[i].maximum);
+      }
+      this->nodes.push_back (Node ());
+      this->buildNode (0, 0, n);
+    }
+  }
+
+  void buildNode (unsigned int node, unsigned int first, unsigned int last)
+  {
+    Box box = this->boxes[this->elements[first]];
+    Box centers = {this->center (this->elements[first]), this->center (this->elements[first])};
+
+    for (unsigned int i = first + 1; i < last; i++)
+    {
+      const glm::vec3 c = this->center (this->elements[i]);
+
+      box.extend (this->boxes[this->elements[i]]);
+      centers.extend ({c, c});
+    }
+    this->nodes[node].box = box;
+
+    if (last - first <= maxElementsPerLeaf)
+    {
+      this->nodes[node].first = first;
+      this->nodes[node].numElements = last - first;
+    }
+    else
+    {
+      const glm::vec3    extent = centers.maximum - centers.minimum;
+      const unsigned int axis =
+        extent.x >= extent.y ? (extent.x >= extent.z ? 0 : 2) : (extent.y >= extent.z ? 1 : 2);
+      const unsigned int middle = (first + last) / 2;
+      const unsigned int children = this->nodes.size ();
+
+      std::nth_element (this->elements.begin () + first, this->elements.begin () + middle,
+                        this->elements.begin () + last,
+                        [this, axis](unsigned int a, unsigned int b) {
+                          return this->center (a)[axis] < this->center (b)[axis];
+                        });
+
+      this->nodes[node].first = children;
+      this->nodes[node].numElements = 0;
+      this->nodes.push_back (Node ());
+      this->nodes.push_back (Node ());
+
+      this->buildNode (children, first, middle);
+      this->buildNode (children + 1, middle, last);
+    }
+  }
+
+  glm::vec3 center (unsigned int e) const
+  {
+    return 0.5f * (this->boxes[e].minimum + this->boxes[e].maximum);
+  }
+
+  void refit (const BoundsCallback& getBounds)
+  {
+    for (unsigned int i = 0; i < this->boxes.size (); i++)
+    {
+      getBounds (i, this->boxes[i].minimum, this->boxes[i].maximum);
+    }
+
+    // children are stored after their parent
+    for (auto node = this->nodes.rbegin (); node != this->nodes.rend (); ++node)
+    {
+      if (node->isLeaf ())
+      {
+        node->box = this->boxes[this->elements[node->first]];
+
+        for (unsigned int i = 1; i < node->numElements; i++)
+        {
+          node->box.extend (this->boxes[this->elements[node->first + i]]);
+        }
+      }
+      else
+      {
+        node->box = this->nodes[node->first].box;
+        node->box.extend (this->nodes[node->first + 1].box);
+      }
+    }
+  }
+
+  void reset ()
+  {
+    this->nodes.clear ();
+    this->elements.clear ();
+    this->boxes.clear ();
+  }
+
+  void intersects (const PrimRay& ray, float maxDistance, const RayIntersectionCallback& f) const
+  {
+    std::vector<QueueItem> queue;
+    float                  distance = maxDistance;
+    float                  t;
+
+    const auto enqueue = [this, &ray, &queue, &distance, &t](unsigned int node) {
+      if (this->nodes[node].box.intersects (ray, t) && t <= distance)
+      {
+        queue.push_back ({t, node});
+        std::push_heap (queue.begin (), queue.end ());
+      }
+    };
+
+    if (this->nodes.empty () == false)
+    {
+      enqueue (0);
+    }
+    while (queue.empty () == false && queue.front ().distance <= distance)
+    {
+      const Node& node = this->nodes[queue.front ().node];
+
+      std::pop_heap (queue.begin (), queue.end ());
+      queue.pop_back ();
+
+      if (node.isLeaf ())
+      {
+        for (unsigned int i = node.first; i < node.first + node.numElements; i++)
+        {
+          if (this->boxes[this->elements[i]].intersects (ray, t) && t <= distance)
+          {
+            distance = glm::min (distance, f (this->elements[i]));
+          }
+        }
+      }
+      else
+      {
+        enqueue (node.first);
+        enqueue (node.first + 1);
+      }
+    }
+  }
+
+  void intersects (const glm::vec3& point, const IntersectionCallback& f) const
+  {
+    std::vector<unsigned int> stack;
+
+    if (this->nodes.empty () == false)
+    {
+      stack.push_back (0);
+    }
+    while (stack.empty () == false)
+    {
+      const Node& node = this->nodes[stack.back ()];
+
+      stack.pop_back ();
+
+      if (node.box.contains (point))
+      {
+        if (node.isLeaf ())
+        {
+          for (unsigned int i = node.first; i < node.first + node.numElements; i++)
+          {
+            if (this->boxes[this->elements[i]].contains (point))
+            {
+              f (this->elements[i]);
+            }
+          }
+        }
+        else
+        {
+          stack.push_back (node.first);
+          stack.push_back (node.first + 1);
+        }
+      }
+    }
+  }
+};
+
+DELEGATE_BIG6 (BVH)
+DELEGATE_CONST (unsigned int, BVH, numElements)
+DELEGATE2 (void, BVH, build, unsigned int, const BVH::BoundsCallback&)
+DELEGATE1 (void, BVH, refit, const BVH::BoundsCallback&)
+DELEGATE (void, BVH, reset)
+DELEGATE3_CONST (void, BVH, intersects, const PrimRay&, float, const BVH::RayIntersectionCallback&)
+DELEGATE2_CONST (void, BVH, intersects, const glm::vec3&, const BVH::IntersectionCallback&)
@@ -0,0 +1,43 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_BVH
+#define DILAY_BVH
+
+#include <functional>
+#include <glm/fwd.hpp>
+#include "macro.hpp"
+
+class PrimRay;
+
+/* Bounding volume hierarchy of the axis-aligned bounding boxes of indexed elements.
+ * `build` sets up the hierarchy by splitting elements at the median of their centers.
+ * `refit` updates the boxes after elements moved or changed, but keeps the hierarchy's structure.
+ */
+class BVH
+{
+public:
+  DECLARE_BIG6 (BVH)
+
+  typedef std::function<void(unsigned int, glm::vec3&, glm::vec3&)> BoundsCallback;
+  typedef std::function<float(unsigned int)>                        RayIntersectionCallback;
+  typedef std::function<void(unsigned int)>                         IntersectionCallback;
+
+  unsigned int numElements () const;
+  void         build (unsigned int, const BoundsCallback&);
+  void         refit (const BoundsCallback&);
+  void         reset ();
+
+  // visits elements in near-to-far order of their boxes: the callback returns the distance of the
+  // nearest intersection found so far, elements whose boxes are farther away are skipped
+  void intersects (const PrimRay&, float, const RayIntersectionCallback&) const;
+
+  // visits elements whose boxes contain a point
+  void intersects (const glm::vec3&, const IntersectionCallback&) const;
+
+private:
+  IMPLEMENTATION
+};
+
+#endif
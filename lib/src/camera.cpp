@@ -50,6 +50,8 @@ struct Camera::Impl
 
   glm::vec3 position () const { return this->gazePoint + this->toEyePoint; }
 
+  glm::mat4x4 viewProjection () const { return this->projection * this->view; }
+
   glm::mat4x4 world () const
   {
     const glm::vec3 x = this->right;
@@ -160,6 +162,13 @@ struct Camera::Impl
     return onNearPlane * (this->nearClipping + z) / this->nearClipping;
   }
 
+  float fromWorld (float length, float z) const
+  {
+    const float onNearPlane = length * this->nearClipping / (this->nearClipping + z);
+    return onNearPlane * float(this->resolution.x) /
+           (2.0f * this->nearClipping * glm::tan (this->fieldOfView * 0.5f));
+  }
+
   PrimRay ray (const glm::ivec2& p) const
   {
     const glm::vec3 w = this->toWorld (p);
@@ -248,6 +257,7 @@ DELEGATE_CONST (glm::vec3, Camera, realUp)
 GETTER_CONST (const glm::vec3&, Camera, right)
 GETTER_CONST (const glm::mat4x4&, Camera, view)
 GETTER_CONST (const glm::mat4x4&, Camera, viewRotation)
+DELEGATE_CONST (glm::mat4x4, Camera, viewProjection)
 DELEGATE_CONST (glm::vec3, Camera, position)
 DELEGATE_CONST (glm::mat4x4, Camera, world)
 DELEGATE1 (void, Camera, updateResolution, const glm::uvec2&)
@@ -258,6 +268,7 @@ DELEGATE1 (void, Camera, stepAlongGaze, float)
 DELEGATE1 (void, Camera, verticalRotation, float)
 DELEGATE1 (void, Camera, horizontalRotation, float)
 DELEGATE3_CONST (glm::vec2, Camera, fromWorld, const glm::vec3&, const glm::mat4x4&, bool)
+DELEGATE2_CONST (float, Camera, fromWorld, float, float)
 DELEGATE2_CONST (glm::vec3, Camera, toWorld, const glm::ivec2&, float)
 DELEGATE2_CONST (float, Camera, toWorld, float, float)
 DELEGATE1_CONST (PrimRay, Camera, ray, const glm::ivec2&)
@@ -26,6 +26,7 @@ public:
   const glm::vec3&   right () const;
   const glm::mat4x4& view () const;
   const glm::mat4x4& viewRotation () const;
+  glm::mat4x4        viewProjection () const;
   glm::vec3          position () const;
   glm::mat4x4        world () const;
 
@@ -38,6 +39,7 @@ public:
   void      verticalRotation (float);
   void      horizontalRotation (float);
   glm::vec2 fromWorld (const glm::vec3&, const glm::mat4x4&, bool) const;
+  float     fromWorld (float, float = 0.0f) const;
   glm::vec3 toWorld (const glm::ivec2&, float = 0.0f) const;
   float     toWorld (float, float = 0.0f) const;
   PrimRay   ray (const glm::ivec2&) const;
@@ -94,6 +94,10 @@ void Config::restoreDefaults ()
 
   this->set ("editor/use-geometry-shader", true);
 
+  this->set ("editor/show-frame-times", false);
+
+  this->set ("editor/use-pick-buffer", false);
+
   this->set ("window/initial-width", 1024);
   this->set ("window/initial-height", 768);
 }
@@ -0,0 +1,448 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <deque>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+#include "../mesh.hpp"
+#include "camera.hpp"
+#include "dynamic/chunks.hpp"
+#include "dynamic/mesh.hpp"
+#include "hash.hpp"
+#include "intersection.hpp"
+#include "opengl-buffer-id.hpp"
+#include "opengl.hpp"
+#include "primitive/aabox.hpp"
+#include "primitive/frustum.hpp"
+#include "primitive/triangle.hpp"
+#include "render-mode.hpp"
+#include "util.hpp"
+
+namespace
+{
+  struct CellHash
+  {
+    std::size_t operator() (const glm::ivec3& cell) const
+    {
+      std::size_t seed = 0;
+      Hash::combine (seed, cell.x);
+      Hash::combine (seed, cell.y);
+      Hash::combine (seed, cell.z);
+      return seed;
+    }
+  };
+
+  // cf. `DynamicChunks::Impl::updateFace`
+  constexpr unsigned char faceIsClean = 0;
+  constexpr unsigned char faceIsMoved = 1;
+  constexpr unsigned char faceIsChanged = 2;
+
+  struct Chunk
+  {
+    glm::ivec3                cell;
+    std::vector<unsigned int> faces;
+    glm::vec3                 minimum;
+    glm::vec3                 maximum;
+    OpenGLBufferId            id;
+    unsigned int              bufferSize;
+    unsigned int              numIndices;
+    bool                      isDirty;
+
+    // corner indices of `faces`, cf. `Mesh::Impl::render`
+    mutable OpenGLBufferId cornerId;
+    mutable bool           cornersAreDirty;
+
+    Chunk (const glm::ivec3& c)
+      : cell (c)
+      , bufferSize (0)
+      , numIndices (0)
+      , isDirty (true)
+      , cornersAreDirty (true)
+    {
+      this->resetBounds ();
+    }
+
+    void resetBounds ()
+    {
+      this->minimum = glm::vec3 (Util::maxFloat ());
+      this->maximum = glm::vec3 (Util::minFloat ());
+    }
+
+    void extendBounds (const glm::vec3& v)
+    {
+      this->minimum = glm::min (this->minimum, v);
+      this->maximum = glm::max (this->maximum, v);
+    }
+
+    void extendBounds (const PrimTriangle& tri)
+    {
+      this->extendBounds (tri.vertex1 ());
+      this->extendBounds (tri.vertex2 ());
+      this->extendBounds (tri.vertex3 ());
+    }
+
+    // the bounds are loosened like the nodes of `DynamicOctree`, because moving a vertex does not
+    // realign all of its adjacent faces
+    PrimAABox looseAABox (float cellWidth) const
+    {
+      const glm::vec3 padding (cellWidth * 0.5f);
+      return PrimAABox (this->minimum - padding, this->maximum + padding);
+    }
+
+    bool needsBuffering () const
+    {
+      return this->isDirty || (this->id.isValid () == false && this->faces.empty () == false);
+    }
+  };
+}
+
+struct DynamicChunks::Impl
+{
+  static constexpr unsigned int numFacesPerChunk = 4096;
+  static constexpr unsigned int maxNumFacesPerChunk = 4 * numFacesPerChunk;
+
+  // cf. `reset`
+  float                                                  cellWidth;
+  std::deque<Chunk>                                      chunks;
+  std::unordered_map<glm::ivec3, unsigned int, CellHash> cellChunkMap;
+  std::vector<unsigned int>                              faceChunk;
+  std::vector<unsigned int>                              facePosition;
+  std::vector<unsigned char>                             faceState;
+  std::vector<unsigned int>                              dirtyFaces;
+  std::vector<unsigned int>                              indexData;
+
+  Impl ()
+    : cellWidth (0.0f)
+  {
+  }
+
+  bool isSetUp () const { return this->cellWidth > 0.0f; }
+
+  unsigned int numChunks () const { return this->chunks.size (); }
+
+  void reset ()
+  {
+    this->cellWidth = 0.0f;
+    this->chunks.clear ();
+    this->cellChunkMap.clear ();
+    this->faceChunk.clear ();
+    this->facePosition.clear ();
+    this->faceState.clear ();
+    this->dirtyFaces.clear ();
+  }
+
+  void resizeFaces (unsigned int n)
+  {
+    if (n > this->faceState.size ())
+    {
+      this->faceChunk.resize (n, Util::invalidIndex ());
+      this->facePosition.resize (n, Util::invalidIndex ());
+      this->faceState.resize (n, faceIsClean);
+    }
+  }
+
+  void markFace (unsigned int i, unsigned char state)
+  {
+    // faces are assigned in bulk when setting up the chunks
+    if (this->isSetUp ())
+    {
+      this->resizeFaces (i + 1);
+
+      if (this->faceState[i] == faceIsClean)
+      {
+        this->dirtyFaces.push_back (i);
+      }
+      this->faceState[i] = glm::max (this->faceState[i], state);
+    }
+  }
+
+  void addFace (unsigned int i) { this->markFace (i, faceIsChanged); }
+
+  void deleteFace (unsigned int i) { this->markFace (i, faceIsChanged); }
+
+  void realignFace (unsigned int i) { this->markFace (i, faceIsMoved); }
+
+  glm::ivec3 cell (const glm::vec3& position) const
+  {
+    return glm::ivec3 (glm::floor (position / this->cellWidth));
+  }
+
+  unsigned int chunkIndex (const glm::vec3& position)
+  {
+    const glm::ivec3 key = this->cell (position);
+    const auto       it = this->cellChunkMap.find (key);
+
+    if (it == this->cellChunkMap.end ())
+    {
+      this->chunks.emplace_back (key);
+      this->cellChunkMap.emplace (key, this->chunks.size () - 1);
+      return this->chunks.size () - 1;
+    }
+    else
+    {
+      return it->second;
+    }
+  }
+
+  void insertFace (unsigned int i, unsigned int c, const PrimTriangle& tri)
+  {
+    assert (this->faceChunk[i] == Util::invalidIndex ());
+
+    Chunk& chunk = this->chunks[c];
+
+    this->faceChunk[i] = c;
+    this->facePosition[i] = chunk.faces.size ();
+    chunk.faces.push_back (i);
+    chunk.extendBounds (tri);
+    chunk.isDirty = true;
+  }
+
+  void removeFace (unsigned int i)
+  {
+    const unsigned int c = this->faceChunk[i];
+
+    if (c != Util::invalidIndex ())
+    {
+      Chunk&             chunk = this->chunks[c];
+      const unsigned int position = this->facePosition[i];
+      const unsigned int last = chunk.faces.back ();
+
+      chunk.faces[position] = last;
+      chunk.faces.pop_back ();
+      chunk.isDirty = true;
+
+      this->facePosition[last] = position;
+      this->faceChunk[i] = Util::invalidIndex ();
+      this->facePosition[i] = Util::invalidIndex ();
+    }
+  }
+
+  // a face stays in its chunk as long as its center lies within the chunk's cell extended by half
+  // the cell width, so that small movements do not re-upload index data
+  bool looseContains (const Chunk& chunk, const glm::vec3& position) const
+  {
+    const glm::vec3 cellCenter = (glm::vec3 (chunk.cell) + glm::vec3 (0.5f)) * this->cellWidth;
+    return glm::all (glm::lessThanEqual (glm::abs (position - cellCenter),
+                                         glm::vec3 (this->cellWidth)));
+  }
+
+  void updateFace (const DynamicMesh& mesh, unsigned int i)
+  {
+    if (mesh.isFreeFace (i))
+    {
+      this->removeFace (i);
+    }
+    else
+    {
+      const PrimTriangle tri = mesh.face (i);
+      const unsigned int c = this->faceChunk[i];
+
+      if (c != Util::invalidIndex () && this->looseContains (this->chunks[c], tri.center ()))
+      {
+        // a moved face only changes the vertex buffer
+        this->chunks[c].extendBounds (tri);
+
+        if (this->faceState[i] == faceIsChanged)
+        {
+          this->chunks[c].isDirty = true;
+        }
+      }
+      else
+      {
+        this->removeFace (i);
+        this->insertFace (i, this->chunkIndex (tri.center ()), tri);
+      }
+    }
+    this->faceState[i] = faceIsClean;
+  }
+
+  void setup (const DynamicMesh& mesh, float maxCellWidth)
+  {
+    this->reset ();
+
+    if (mesh.isEmpty () == false)
+    {
+      const unsigned int numFaces = mesh.mesh ().numIndices () / 3;
+      const glm::vec3    extent = mesh.mesh ().bounds ().halfWidth () * 2.0f;
+      const float        maxExtent = glm::max (glm::max (extent.x, extent.y), extent.z);
+
+      // the faces of a mesh approximate a surface, i.e. they are distributed over a number of
+      // cells that grows quadratically with the number of cells per dimension
+      const float numCellsPerDim =
+        glm::ceil (glm::sqrt (float(mesh.numFaces ()) / float(Impl::numFacesPerChunk)));
+
+      this->cellWidth = glm::min (maxCellWidth, maxExtent / glm::max (1.0f, numCellsPerDim));
+      this->cellWidth = glm::max (this->cellWidth, Util::epsilon ());
+      this->resizeFaces (numFaces);
+
+      for (unsigned int i = 0; i < numFaces; i++)
+      {
+        if (mesh.isFreeFace (i) == false)
+        {
+          const PrimTriangle tri = mesh.face (i);
+          this->insertFace (i, this->chunkIndex (tri.center ()), tri);
+        }
+      }
+    }
+  }
+
+  bool hasOversizedChunk () const
+  {
+    for (const Chunk& chunk : this->chunks)
+    {
+      if (chunk.faces.size () > Impl::maxNumFacesPerChunk)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void bufferChunk (const DynamicMesh& mesh, Chunk& chunk)
+  {
+    this->indexData.clear ();
+    chunk.resetBounds ();
+
+    for (unsigned int f : chunk.faces)
+    {
+      unsigned int i1, i2, i3;
+      mesh.vertexIndices (f, i1, i2, i3);
+
+      this->indexData.push_back (i1);
+      this->indexData.push_back (i2);
+      this->indexData.push_back (i3);
+
+      chunk.extendBounds (mesh.vertex (i1));
+      chunk.extendBounds (mesh.vertex (i2));
+      chunk.extendBounds (mesh.vertex (i3));
+    }
+
+    if (chunk.id.isValid () == false)
+    {
+      chunk.id.allocate ();
+      chunk.bufferSize = 0;
+    }
+    OpenGL::glBindBuffer (OpenGL::ElementArrayBuffer (), chunk.id.id ());
+
+    const unsigned int dataSize = this->indexData.size () * sizeof (unsigned int);
+
+    if (chunk.bufferSize < dataSize)
+    {
+      const unsigned int newBufferSize = dataSize + (dataSize / 2);
+
+      OpenGL::glBufferData (OpenGL::ElementArrayBuffer (), newBufferSize, nullptr,
+                            OpenGL::StaticDraw ());
+      OpenGL::glBufferSubData (OpenGL::ElementArrayBuffer (), 0, dataSize,
+                               this->indexData.data ());
+      chunk.bufferSize = newBufferSize;
+    }
+    else if (dataSize > 0)
+    {
+      OpenGL::glBufferSubData (OpenGL::ElementArrayBuffer (), 0, dataSize,
+                               this->indexData.data ());
+    }
+    chunk.numIndices = this->indexData.size ();
+    chunk.cornersAreDirty = true;
+    chunk.isDirty = false;
+  }
+
+  void bufferData (const DynamicMesh& mesh)
+  {
+    if (this->isSetUp () == false)
+    {
+      this->setup (mesh, Util::maxFloat ());
+    }
+    else
+    {
+      for (unsigned int i : this->dirtyFaces)
+      {
+        this->updateFace (mesh, i);
+      }
+      this->dirtyFaces.clear ();
+
+      if (this->hasOversizedChunk ())
+      {
+        this->setup (mesh, this->cellWidth * 0.5f);
+      }
+    }
+
+    for (Chunk& chunk : this->chunks)
+    {
+      if (chunk.needsBuffering ())
+      {
+        this->bufferChunk (mesh, chunk);
+      }
+    }
+    OpenGL::glBindBuffer (OpenGL::ElementArrayBuffer (), 0);
+  }
+
+  // the corner of a face's vertex is its position in the mesh's indices, i.e. corner indices
+  // only change if the chunk's faces change
+  void bufferCorners (const Chunk& chunk) const
+  {
+    if (chunk.cornersAreDirty || chunk.cornerId.isValid () == false)
+    {
+      std::vector<unsigned int> cornerData;
+      cornerData.reserve (3 * chunk.faces.size ());
+
+      for (unsigned int f : chunk.faces)
+      {
+        cornerData.push_back ((3 * f) + 0);
+        cornerData.push_back ((3 * f) + 1);
+        cornerData.push_back ((3 * f) + 2);
+      }
+
+      if (chunk.cornerId.isValid () == false)
+      {
+        chunk.cornerId.allocate ();
+      }
+      OpenGL::glBindBuffer (OpenGL::ElementArrayBuffer (), chunk.cornerId.id ());
+      OpenGL::glBufferData (OpenGL::ElementArrayBuffer (),
+                            cornerData.size () * sizeof (unsigned int), cornerData.data (),
+                            OpenGL::StaticDraw ());
+      chunk.cornersAreDirty = false;
+    }
+    else
+    {
+      OpenGL::glBindBuffer (OpenGL::ElementArrayBuffer (), chunk.cornerId.id ());
+    }
+  }
+
+  void render (Camera& camera, const DynamicMesh& mesh) const
+  {
+    const PrimFrustum frustum =
+      PrimFrustum (camera.viewProjection ()).transform (mesh.mesh ().modelMatrix ());
+    const bool useCorners = mesh.mesh ().renderMode ().renderBarycentricWireframe ();
+
+    mesh.mesh ().render (camera, [this, &frustum, useCorners]() {
+      for (const Chunk& chunk : this->chunks)
+      {
+        if (chunk.numIndices > 0 && chunk.id.isValid () &&
+            IntersectionUtil::intersects (frustum, chunk.looseAABox (this->cellWidth)))
+        {
+          if (useCorners)
+          {
+            this->bufferCorners (chunk);
+          }
+          else
+          {
+            OpenGL::glBindBuffer (OpenGL::ElementArrayBuffer (), chunk.id.id ());
+          }
+          OpenGL::glDrawElements (OpenGL::Triangles (), chunk.numIndices, OpenGL::UnsignedInt (),
+                                  nullptr);
+        }
+      }
+    });
+  }
+};
+
+DELEGATE_BIG4_COPY (DynamicChunks)
+DELEGATE_CONST (unsigned int, DynamicChunks, numChunks)
+DELEGATE1 (void, DynamicChunks, addFace, unsigned int)
+DELEGATE1 (void, DynamicChunks, deleteFace, unsigned int)
+DELEGATE1 (void, DynamicChunks, realignFace, unsigned int)
+DELEGATE (void, DynamicChunks, reset)
+DELEGATE1 (void, DynamicChunks, bufferData, const DynamicMesh&)
+DELEGATE2_CONST (void, DynamicChunks, render, Camera&, const DynamicMesh&)
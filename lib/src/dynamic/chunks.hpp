@@ -0,0 +1,35 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_DYNAMIC_CHUNKS
+#define DILAY_DYNAMIC_CHUNKS
+
+#include "macro.hpp"
+
+class Camera;
+class DynamicMesh;
+
+/* Spatial chunks of a dynamic mesh's faces.
+ * Each chunk owns a separate index buffer, so that an edit re-uploads only the chunks it touched
+ * and chunks outside the view frustum are skipped when rendering.
+ * Faces are assigned to the cells of a uniform grid in the mesh's local space.
+ */
+class DynamicChunks
+{
+public:
+  DECLARE_BIG4_EXPLICIT_COPY (DynamicChunks)
+
+  unsigned int numChunks () const;
+  void         addFace (unsigned int);
+  void         deleteFace (unsigned int);
+  void         realignFace (unsigned int);
+  void         reset ();
+  void         bufferData (const DynamicMesh&);
+  void         render (Camera&, const DynamicMesh&) const;
+
+private:
+  IMPLEMENTATION
+};
+
+#endif
@@ -2,40 +2,91 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
 #include "dynamic/faces.hpp"
 
-void DynamicFaces::insert (unsigned int i) { this->_uncommitted.insert (i); }
+namespace
+{
+  constexpr unsigned char isCommitted = 1;
+  constexpr unsigned char isUncommitted = 2;
+  constexpr unsigned int  initialNumSlots = 16;
+  constexpr unsigned int  emptyIndex = ~0u;
+
+  // Fibonacci hashing: `numSlots` is a power of two
+  unsigned int hashIndex (unsigned int i, unsigned int numSlots)
+  {
+    return unsigned ((uint64_t (i) * 0x9e3779b97f4a7c15ull) >> 32) & (numSlots - 1);
+  }
+}
+
+void DynamicFaces::insert (unsigned int i)
+{
+  unsigned char& flags = this->flags (i);
+
+  if ((flags & isUncommitted) == 0)
+  {
+    flags |= isUncommitted;
+    this->_uncommitted.push_back (i);
+  }
+}
 
 void DynamicFaces::insert (const DynamicFaces::Container& v)
 {
-  this->_uncommitted.insert (v.begin (), v.end ());
+  for (unsigned int i : v)
+  {
+    this->insert (i);
+  }
 }
 
 void DynamicFaces::reset ()
 {
-  this->resetCommitted ();
+  for (unsigned int s : this->_occupied)
+  {
+    this->_slots[s] = Slot{emptyIndex, 0};
+  }
+  this->_occupied.clear ();
+  this->_indices.clear ();
   this->_uncommitted.clear ();
 }
 
-void DynamicFaces::resetCommitted () { this->_indices.clear (); }
+void DynamicFaces::resetCommitted ()
+{
+  for (unsigned int i : this->_indices)
+  {
+    this->flags (i) &= ~isCommitted;
+  }
+  this->_indices.clear ();
+}
 
 void DynamicFaces::commit ()
 {
   if (this->_indices.empty ())
   {
+    for (unsigned int i : this->_uncommitted)
+    {
+      this->flags (i) = isCommitted;
+    }
     this->_indices.swap (this->_uncommitted);
   }
   else
   {
-    this->_indices.insert (this->_uncommitted.begin (), this->_uncommitted.end ());
+    for (unsigned int i : this->_uncommitted)
+    {
+      unsigned char& flags = this->flags (i);
+
+      if ((flags & isCommitted) == 0)
+      {
+        this->_indices.push_back (i);
+      }
+      flags = isCommitted;
+    }
     this->_uncommitted.clear ();
   }
 }
 
-bool DynamicFaces::contains (unsigned int i) const
-{
-  return this->_indices.find (i) != this->_indices.end ();
-}
+bool DynamicFaces::contains (unsigned int i) const { return this->flags (i) & isCommitted; }
 
 bool DynamicFaces::isEmpty () const
 {
@@ -46,26 +97,86 @@ bool DynamicFaces::hasUncomitted () const { return this->_uncommitted.empty () =
 
 void DynamicFaces::filter (const std::function<bool(unsigned int)>& f)
 {
-  for (auto it = this->_indices.begin (); it != this->_indices.end ();)
+  const auto filterElements = [this, &f](Container& elements, unsigned char flag) {
+    auto it = std::remove_if (elements.begin (), elements.end (), [this, &f, flag](unsigned int i) {
+      if (f (i))
+      {
+        return false;
+      }
+      else
+      {
+        this->flags (i) &= ~flag;
+        return true;
+      }
+    });
+    elements.erase (it, elements.end ());
+  };
+  filterElements (this->_indices, isCommitted);
+  filterElements (this->_uncommitted, isUncommitted);
+}
+
+unsigned int DynamicFaces::findSlot (unsigned int i) const
+{
+  const unsigned int numSlots = this->_slots.size ();
+
+  for (unsigned int s = hashIndex (i, numSlots);; s = (s + 1) & (numSlots - 1))
   {
-    if (f (*it) == false)
-    {
-      it = this->_indices.erase (it);
-    }
-    else
+    if (this->_slots[s].index == i || this->_slots[s].index == emptyIndex)
     {
-      ++it;
+      return s;
     }
   }
-  for (auto it = this->_uncommitted.begin (); it != this->_uncommitted.end ();)
+}
+
+// returns the flags of `i`, a slot is occupied if `i` has none yet. Occupied slots are only freed
+// by `reset`, i.e. an index keeps its slot if it is filtered out and inserted again.
+unsigned char& DynamicFaces::flags (unsigned int i)
+{
+  assert (i != emptyIndex);
+
+  unsigned int s = this->_slots.empty () ? 0 : this->findSlot (i);
+
+  if (this->_slots.empty () || this->_slots[s].index == emptyIndex)
   {
-    if (f (*it) == false)
-    {
-      it = this->_uncommitted.erase (it);
-    }
-    else
+    if (2 * (this->_occupied.size () + 1) > this->_slots.size ())
     {
-      ++it;
+      this->grow ();
+      s = this->findSlot (i);
     }
+    this->_slots[s].index = i;
+    this->_occupied.push_back (s);
+  }
+  return this->_slots[s].flags;
+}
+
+unsigned char DynamicFaces::flags (unsigned int i) const
+{
+  if (this->_slots.empty ())
+  {
+    return 0;
+  }
+  else
+  {
+    const Slot& slot = this->_slots[this->findSlot (i)];
+    return slot.index == i ? slot.flags : 0;
+  }
+}
+
+void DynamicFaces::grow ()
+{
+  const unsigned int numSlots = std::max (initialNumSlots, 2 * unsigned(this->_slots.size ()));
+  std::vector<Slot>  oldSlots (numSlots, Slot{emptyIndex, 0});
+  Container          oldOccupied;
+
+  this->_slots.swap (oldSlots);
+  this->_occupied.swap (oldOccupied);
+  this->_occupied.reserve (oldOccupied.size ());
+
+  for (unsigned int s : oldOccupied)
+  {
+    const unsigned int newS = this->findSlot (oldSlots[s].index);
+
+    this->_slots[newS] = oldSlots[s];
+    this->_occupied.push_back (newS);
   }
 }
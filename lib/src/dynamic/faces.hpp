@@ -6,12 +6,18 @@
 #define DILAY_DYNAMIC_FACES
 
 #include <functional>
-#include <unordered_set>
+#include <vector>
 
+/* A set of face indices with committed and uncommitted elements.
+ * Elements are stored densely in insertion order. Membership flags are kept in an open-addressing
+ * hash table, such that storing, resetting and copying a set scales with its number of elements
+ * instead of with the mesh's number of faces.
+ * Iterating the committed elements stays valid while inserting uncommitted ones.
+ */
 class DynamicFaces
 {
 public:
-  typedef std::unordered_set<unsigned int> Container;
+  typedef std::vector<unsigned int> Container;
 
   const Container& indices () const { return this->_indices; }
   const Container& uncommitted () const { return this->_uncommitted; }
@@ -33,8 +39,21 @@ public:
   void filter (const std::function<bool(unsigned int)>&);
 
 private:
-  Container _indices;
-  Container _uncommitted;
+  struct Slot
+  {
+    unsigned int  index;
+    unsigned char flags;
+  };
+
+  unsigned int   findSlot (unsigned int) const;
+  unsigned char& flags (unsigned int);
+  unsigned char  flags (unsigned int) const;
+  void           grow ();
+
+  Container         _indices;
+  Container         _uncommitted;
+  std::vector<Slot> _slots;
+  Container         _occupied;
 };
 
 #endif
@@ -0,0 +1,220 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <atomic>
+#include <glm/glm.hpp>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../mesh.hpp"
+#include "dynamic/lod.hpp"
+#include "dynamic/mesh.hpp"
+#include "tool/sculpt/util/action.hpp"
+#include "util.hpp"
+
+namespace
+{
+  constexpr unsigned int minNumFaces = 100000;
+  constexpr unsigned int minNumProxyFaces = 2000;
+  constexpr unsigned int maxNumProxies = 4;
+  constexpr unsigned int reductionPerProxy = 4;
+  constexpr unsigned int numFacesPerCancelCheck = 4096;
+
+  struct Job
+  {
+    std::mutex        mutex;
+    std::vector<Mesh> proxies;
+    std::atomic<bool> isCancelled;
+
+    Job ()
+      : isCancelled (false)
+    {
+    }
+  };
+
+  // copies all non-free faces and their vertices
+  Mesh snapshot (const DynamicMesh& mesh)
+  {
+    const Mesh&               source = mesh.mesh ();
+    std::vector<unsigned int> vertexMap (source.numVertices (), Util::invalidIndex ());
+    Mesh                      snapshot;
+
+    snapshot.reserveIndices (3 * mesh.numFaces ());
+    snapshot.reserveVertices (mesh.numVertices ());
+
+    const auto addIndex = [&source, &vertexMap, &snapshot](unsigned int i) {
+      if (vertexMap[i] == Util::invalidIndex ())
+      {
+        vertexMap[i] = snapshot.addVertex (source.vertex (i), source.normal (i));
+      }
+      snapshot.addIndex (vertexMap[i]);
+    };
+
+    for (unsigned int i = 0; i < source.numIndices () / 3; i++)
+    {
+      if (mesh.isFreeFace (i) == false)
+      {
+        unsigned int i1, i2, i3;
+        mesh.vertexIndices (i, i1, i2, i3);
+
+        addIndex (i1);
+        addIndex (i2);
+        addIndex (i3);
+      }
+    }
+    return snapshot;
+  }
+
+  float averageEdgeLength (DynamicMesh& mesh)
+  {
+    float sum = 0.0f;
+
+    mesh.forEachFace ([&mesh, &sum](unsigned int i) {
+      unsigned int i1, i2, i3;
+      mesh.vertexIndices (i, i1, i2, i3);
+
+      sum += glm::distance (mesh.vertex (i1), mesh.vertex (i2));
+      sum += glm::distance (mesh.vertex (i2), mesh.vertex (i3));
+      sum += glm::distance (mesh.vertex (i3), mesh.vertex (i1));
+    });
+    return sum / float(3 * mesh.numFaces ());
+  }
+
+  // runs in the worker thread of `DynamicLod`: neither `mesh` nor the proxies are buffered here
+  void buildProxies (std::shared_ptr<Job> job, Mesh source)
+  {
+    DynamicMesh mesh;
+
+    for (unsigned int i = 0; i < source.numVertices (); i++)
+    {
+      mesh.addVertex (source.vertex (i), source.normal (i));
+    }
+    for (unsigned int i = 0; i < source.numIndices (); i += 3)
+    {
+      if (i % (3 * numFacesPerCancelCheck) == 0 && job->isCancelled)
+      {
+        return;
+      }
+      mesh.addFace (source.index (i), source.index (i + 1), source.index (i + 2));
+    }
+    source.reset ();
+
+    for (unsigned int n = 0; n < maxNumProxies; n++)
+    {
+      const unsigned int targetNumFaces = mesh.numFaces () / reductionPerProxy;
+
+      if (targetNumFaces < minNumProxyFaces)
+      {
+        return;
+      }
+      while (mesh.numFaces () > targetNumFaces)
+      {
+        if (job->isCancelled)
+        {
+          return;
+        }
+        else if (ToolSculptAction::reduceMesh (mesh, 2.0f * averageEdgeLength (mesh),
+                                               job->isCancelled) == false)
+        {
+          return;
+        }
+      }
+      if (job->isCancelled)
+      {
+        return;
+      }
+      mesh.prune ();
+
+      std::lock_guard<std::mutex> lock (job->mutex);
+      job->proxies.push_back (mesh.mesh ());
+    }
+  }
+}
+
+struct DynamicLod::Impl
+{
+  std::shared_ptr<Job> job;
+  std::thread          worker;
+  std::vector<Mesh>    proxies;
+
+  Impl () {}
+
+  Impl (const Impl&)
+    : Impl ()
+  {
+  }
+
+  ~Impl () { this->reset (); }
+
+  unsigned int numProxies () const { return this->proxies.size (); }
+
+  void reset ()
+  {
+    if (this->job)
+    {
+      this->job->isCancelled = true;
+      this->job.reset ();
+    }
+    if (this->worker.joinable ())
+    {
+      this->worker.join ();
+    }
+    this->proxies.clear ();
+  }
+
+  void update (const DynamicMesh& mesh)
+  {
+    if (this->job == nullptr)
+    {
+      if (mesh.numFaces () >= minNumFaces)
+      {
+        this->job = std::make_shared<Job> ();
+        this->worker = std::thread (buildProxies, this->job, snapshot (mesh));
+      }
+    }
+    else
+    {
+      std::lock_guard<std::mutex> lock (this->job->mutex);
+
+      for (Mesh& proxy : this->job->proxies)
+      {
+        proxy.bufferData ();
+        this->proxies.push_back (std::move (proxy));
+      }
+      this->job->proxies.clear ();
+    }
+  }
+
+  bool render (Camera& camera, const DynamicMesh& mesh, unsigned int numFaces)
+  {
+    // proxies are ordered from fine to coarse
+    Mesh* proxy = nullptr;
+
+    for (Mesh& p : this->proxies)
+    {
+      if (p.numIndices () / 3 >= numFaces)
+      {
+        proxy = &p;
+      }
+    }
+
+    if (proxy)
+    {
+      proxy->copyNonGeometry (mesh.mesh ());
+      proxy->render (camera);
+      return true;
+    }
+    else
+    {
+      return false;
+    }
+  }
+};
+
+DELEGATE_BIG4_COPY (DynamicLod)
+DELEGATE_CONST (unsigned int, DynamicLod, numProxies)
+DELEGATE (void, DynamicLod, reset)
+DELEGATE1 (void, DynamicLod, update, const DynamicMesh&)
+DELEGATE3 (bool, DynamicLod, render, Camera&, const DynamicMesh&, unsigned int)
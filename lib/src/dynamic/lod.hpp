@@ -0,0 +1,32 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_DYNAMIC_LOD
+#define DILAY_DYNAMIC_LOD
+
+#include "macro.hpp"
+
+class Camera;
+class DynamicMesh;
+
+/* Simplified proxies of a dynamic mesh, which are rendered instead of the mesh while navigating.
+ * Proxies are built by a worker thread from a snapshot of the mesh and are discarded by `reset`
+ * whenever the mesh changes. `reset` and the destructor cancel and join the worker. Copies do not
+ * share or copy proxies.
+ */
+class DynamicLod
+{
+public:
+  DECLARE_BIG4_EXPLICIT_COPY (DynamicLod)
+
+  unsigned int numProxies () const;
+  void         reset ();
+  void         update (const DynamicMesh&);
+  bool         render (Camera&, const DynamicMesh&, unsigned int);
+
+private:
+  IMPLEMENTATION
+};
+
+#endif
@@ -2,6 +2,7 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
 #include <cstring>
 #include <glm/glm.hpp>
 #include <glm/gtx/norm.hpp>
@@ -9,15 +10,19 @@
 #include "../mesh.hpp"
 #include "config.hpp"
 #include "distance.hpp"
+#include "dynamic/chunks.hpp"
 #include "dynamic/faces.hpp"
+#include "dynamic/lod.hpp"
 #include "dynamic/mesh-intersection.hpp"
 #include "dynamic/mesh.hpp"
 #include "dynamic/octree.hpp"
 #include "intersection.hpp"
 #include "mesh-util.hpp"
 #include "primitive/aabox.hpp"
+#include "primitive/frustum.hpp"
 #include "primitive/plane.hpp"
 #include "primitive/ray.hpp"
+#include "primitive/triangle-packet.hpp"
 #include "primitive/triangle.hpp"
 #include "tool/sculpt/util/action.hpp"
 #include "util.hpp"
@@ -56,9 +61,26 @@ namespace
   {
     bool isFree;
 
+    // cross product of the face's edges, i.e. its normal scaled by twice its area.
+    // It is recomputed lazily after one of the face's vertices moved.
+    mutable bool      isDirty;
+    mutable glm::vec3 cross;
+
     FaceData () { this->reset (); }
-    void reset () { this->isFree = true; }
+    void reset ()
+    {
+      this->isFree = true;
+      this->isDirty = true;
+    }
   };
+
+  void sortIntersections (std::vector<Intersection>& intersections)
+  {
+    std::sort (intersections.begin (), intersections.end (),
+               [](const Intersection& a, const Intersection& b) {
+                 return a.distance () < b.distance ();
+               });
+  }
 }
 
 struct DynamicMesh::Impl
@@ -72,18 +94,14 @@ struct DynamicMesh::Impl
   std::vector<unsigned char> faceVisited;
   std::vector<unsigned int>  freeFaceIndices;
   DynamicOctree              octree;
+  DynamicChunks              chunks;
+  DynamicLod                 lod;
 
   Impl (DynamicMesh* s)
     : self (s)
   {
   }
 
-  Impl (DynamicMesh* s, const Mesh& m)
-    : self (s)
-  {
-    this->fromMesh (m);
-  }
-
   unsigned int numVertices () const
   {
     assert (this->mesh.numVertices () >= this->freeVertexIndices.size ());
@@ -142,17 +160,28 @@ struct DynamicMesh::Impl
 
   const glm::vec3& vertexNormal (unsigned int i) const { return this->mesh.normal (i); }
 
-  glm::vec3 faceNormal (unsigned int i) const
+  const glm::vec3& faceCross (unsigned int i) const
   {
     assert (this->isFreeFace (i) == false);
 
-    unsigned int i1, i2, i3;
-    this->vertexIndices (i, i1, i2, i3);
+    const FaceData& data = this->faceData[i];
+
+    if (data.isDirty)
+    {
+      unsigned int i1, i2, i3;
+      this->vertexIndices (i, i1, i2, i3);
 
-    return glm::normalize (glm::cross (this->mesh.vertex (i2) - this->mesh.vertex (i1),
-                                       this->mesh.vertex (i3) - this->mesh.vertex (i1)));
+      data.cross = glm::cross (this->mesh.vertex (i2) - this->mesh.vertex (i1),
+                               this->mesh.vertex (i3) - this->mesh.vertex (i1));
+      data.isDirty = false;
+    }
+    return data.cross;
   }
 
+  glm::vec3 faceNormal (unsigned int i) const { return glm::normalize (this->faceCross (i)); }
+
+  float faceArea (unsigned int i) const { return 0.5f * glm::length (this->faceCross (i)); }
+
   void findAdjacent (unsigned int e1, unsigned int e2, unsigned int& leftFace,
                      unsigned int& leftVertex, unsigned int& rightFace,
                      unsigned int& rightVertex) const
@@ -380,8 +409,7 @@ struct DynamicMesh::Impl
       position += this->mesh.vertex (i1);
       position += this->mesh.vertex (i2);
       position += this->mesh.vertex (i3);
-      normal += glm::cross (this->mesh.vertex (i2) - this->mesh.vertex (i1),
-                            this->mesh.vertex (i3) - this->mesh.vertex (i1));
+      normal += this->faceCross (f);
     }
     position /= float(faces.numElements () * 3);
     normal = glm::normalize (normal);
@@ -421,11 +449,7 @@ struct DynamicMesh::Impl
 
     for (unsigned int f : faces)
     {
-      unsigned int i1, i2, i3;
-      this->vertexIndices (f, i1, i2, i3);
-
-      normal += glm::cross (this->mesh.vertex (i2) - this->mesh.vertex (i1),
-                            this->mesh.vertex (i3) - this->mesh.vertex (i1));
+      normal += this->faceCross (f);
     }
     return glm::normalize (normal);
   }
@@ -439,11 +463,7 @@ struct DynamicMesh::Impl
 
     for (unsigned int f : this->vertexData[i].adjacentFaces)
     {
-      unsigned int i1, i2, i3;
-      this->vertexIndices (f, i1, i2, i3);
-
-      normal += glm::cross (this->mesh.vertex (i2) - this->mesh.vertex (i1),
-                            this->mesh.vertex (i3) - this->mesh.vertex (i1));
+      normal += this->faceCross (f);
     }
     return glm::normalize (normal);
   }
@@ -537,6 +557,7 @@ struct DynamicMesh::Impl
     this->vertexData[i3].addAdjacentFace (index);
 
     this->addFaceToOctree (index);
+    this->chunks.addFace (index);
 
     return index;
   }
@@ -568,19 +589,107 @@ struct DynamicMesh::Impl
     this->freeVertexIndices.push_back (i);
   }
 
+  // adjacent faces are deleted once and only unlinked from vertices that are kept
+  void deleteVertices (const std::vector<unsigned int>& indices)
+  {
+    std::vector<bool> isDeleted (this->vertexData.size (), false);
+
+    for (unsigned int i : indices)
+    {
+      assert (i < this->vertexData.size ());
+      assert (isDeleted[i] == false);
+      isDeleted[i] = true;
+    }
+
+    for (unsigned int i : indices)
+    {
+      for (unsigned int f : this->vertexData[i].adjacentFaces)
+      {
+        if (this->faceData[f].isFree == false)
+        {
+          for (unsigned int j = 0; j < 3; j++)
+          {
+            const unsigned int v = this->mesh.index ((3 * f) + j);
+
+            if (isDeleted[v] == false)
+            {
+              this->vertexData[v].deleteAdjacentFace (f);
+            }
+          }
+          this->freeFace (f);
+        }
+      }
+    }
+
+    for (unsigned int i : indices)
+    {
+      this->vertexData[i].reset ();
+      this->vertexVisited[i] = 0;
+      this->freeVertexIndices.push_back (i);
+    }
+  }
+
   void deleteFace (unsigned int i)
   {
     assert (i < this->faceData.size ());
-    assert (i < this->faceVisited.size ());
+
+    this->vertexData[this->mesh.index ((3 * i) + 0)].deleteAdjacentFace (i);
+    this->vertexData[this->mesh.index ((3 * i) + 1)].deleteAdjacentFace (i);
+    this->vertexData[this->mesh.index ((3 * i) + 2)].deleteAdjacentFace (i);
+
+    this->freeFace (i);
+  }
+
+  // like `deleteFace` followed by an `addFace` that reuses index `i`, but the face is realigned in
+  // the octree instead of being deleted and added again
+  void replaceFace (unsigned int i, unsigned int i1, unsigned int i2, unsigned int i3)
+  {
+    assert (this->isFreeFace (i) == false);
 
     this->vertexData[this->mesh.index ((3 * i) + 0)].deleteAdjacentFace (i);
     this->vertexData[this->mesh.index ((3 * i) + 1)].deleteAdjacentFace (i);
     this->vertexData[this->mesh.index ((3 * i) + 2)].deleteAdjacentFace (i);
 
+    this->faceData[i].reset ();
+    this->faceData[i].isFree = false;
+    this->faceVisited[i] = 0;
+
+    this->mesh.index ((3 * i) + 0, i1);
+    this->mesh.index ((3 * i) + 1, i2);
+    this->mesh.index ((3 * i) + 2, i3);
+
+    this->vertexData[i1].addAdjacentFace (i);
+    this->vertexData[i2].addAdjacentFace (i);
+    this->vertexData[i3].addAdjacentFace (i);
+
+    const PrimTriangle tri = this->face (i);
+
+    this->octree.realignElement (i, tri.center (), tri.maxDimExtent ());
+    this->chunks.addFace (i);
+  }
+
+  void freeFace (unsigned int i)
+  {
+    assert (i < this->faceData.size ());
+    assert (i < this->faceVisited.size ());
+
     this->faceData[i].reset ();
     this->faceVisited[i] = 0;
     this->freeFaceIndices.push_back (i);
     this->octree.deleteElement (i);
+    this->chunks.deleteFace (i);
+  }
+
+  void vertex (unsigned int i, const glm::vec3& v)
+  {
+    assert (this->isFreeVertex (i) == false);
+
+    this->mesh.vertex (i, v);
+
+    for (unsigned int f : this->vertexData[i].adjacentFaces)
+    {
+      this->faceData[f].isDirty = true;
+    }
   }
 
   void vertexNormal (unsigned int i, const glm::vec3& n)
@@ -620,6 +729,8 @@ struct DynamicMesh::Impl
     this->faceVisited.clear ();
     this->freeFaceIndices.clear ();
     this->octree.reset ();
+    this->chunks.reset ();
+    this->lod.reset ();
   }
 
   void fromMesh (const Mesh& mesh)
@@ -640,7 +751,7 @@ struct DynamicMesh::Impl
       this->addFace (mesh.index (i), mesh.index (i + 1), mesh.index (i + 2));
     }
     this->setAllNormals ();
-    this->mesh.bufferData ();
+    this->bufferData ();
   }
 
   void realignFace (unsigned int i)
@@ -650,14 +761,26 @@ struct DynamicMesh::Impl
     const PrimTriangle tri = this->face (i);
 
     this->octree.realignElement (i, tri.center (), tri.maxDimExtent ());
+    this->chunks.realignFace (i);
   }
 
-  void realignFaces (const DynamicFaces& faces)
+  unsigned int realignFaces (const DynamicFaces& faces)
   {
+    const unsigned int numMigrations = this->octree.realignElements (
+      faces.indices (), [this](unsigned int i, glm::vec3& position, float& maxDimExtent) {
+        assert (this->isFreeFace (i) == false);
+
+        const PrimTriangle tri = this->face (i);
+
+        position = tri.center ();
+        maxDimExtent = tri.maxDimExtent ();
+      });
+
     for (unsigned int i : faces)
     {
-      this->realignFace (i);
+      this->chunks.realignFace (i);
     }
+    return numMigrations;
   }
 
   void realignAllFaces ()
@@ -755,6 +878,7 @@ struct DynamicMesh::Impl
       assert (this->numFaces () == newNumFaces);
 
       this->octree.updateIndices (*pFaceIndexMap);
+      this->chunks.reset ();
     }
   }
 
@@ -834,41 +958,26 @@ struct DynamicMesh::Impl
 
   void bufferData ()
   {
-    const auto findNonFreeFaceIndex = [this]() -> unsigned int {
-      assert (this->numFaces () > 0);
-
-      for (unsigned int i = 0; i < this->faceData.size (); i++)
-      {
-        if (this->isFreeFace (i) == false)
-        {
-          return i;
-        }
-      }
-      DILAY_IMPOSSIBLE
-    };
-
-    if (this->numFaces () > 0 && this->freeFaceIndices.empty () == false)
-    {
-      const unsigned int nonFree = findNonFreeFaceIndex ();
-
-      for (unsigned int i : this->freeFaceIndices)
-      {
-        this->mesh.index ((3 * i) + 0, this->mesh.index ((3 * nonFree) + 0));
-        this->mesh.index ((3 * i) + 1, this->mesh.index ((3 * nonFree) + 1));
-        this->mesh.index ((3 * i) + 2, this->mesh.index ((3 * nonFree) + 2));
-      }
-    }
-    this->mesh.bufferData ();
+    this->mesh.bufferVertexData ();
+    this->chunks.bufferData (*this->self);
+    this->lod.reset ();
   }
 
   void render (Camera& camera) const
   {
-    this->mesh.render (camera);
+    this->chunks.render (camera, *this->self);
 #ifdef DILAY_RENDER_OCTREE
     this->octree.render (camera);
 #endif
   }
 
+  void updateProxies () { this->lod.update (*this->self); }
+
+  bool renderProxy (Camera& camera, unsigned int numFaces)
+  {
+    return this->lod.render (camera, *this->self, numFaces);
+  }
+
   bool intersects (const PrimRay& ray, Intersection& intersection, bool bothSides) const
   {
     this->octree.intersects (ray, [this, &ray, &intersection, bothSides](unsigned int i) -> float {
@@ -907,6 +1016,57 @@ struct DynamicMesh::Impl
     return intersection.isIntersection ();
   }
 
+  // unlike `intersects`, distances are not pruned, i.e. all faces along the ray are visited
+  bool intersectsAll (const PrimRay& ray, std::vector<Intersection>& intersections,
+                      bool bothSides) const
+  {
+    intersections.clear ();
+
+    this->octree.intersects (ray, [this, &ray, &intersections, bothSides](unsigned int i) -> float {
+      const PrimTriangle tri = this->face (i);
+      float              t;
+
+      if (IntersectionUtil::intersects (ray, tri, bothSides, &t))
+      {
+        intersections.emplace_back ();
+        intersections.back ().update (t, ray.pointAt (t), tri.normal ());
+      }
+      return Util::maxFloat ();
+    });
+    sortIntersections (intersections);
+    return intersections.empty () == false;
+  }
+
+  // rays of a packet should be coherent (e.g. a row of parallel rays), so that they share most
+  // octree nodes: each node is visited once per packet and each face is loaded once per packet
+  void intersectsAll (const std::vector<PrimRay>&               rays,
+                      std::vector<std::vector<Intersection>>& intersections, bool bothSides) const
+  {
+    intersections.clear ();
+    intersections.resize (rays.size ());
+
+    this->octree.intersects (
+      rays, [this, &rays, &intersections, bothSides](const std::vector<unsigned int>& active,
+                                                      unsigned int                     i) {
+        const PrimTriangle tri = this->face (i);
+
+        for (unsigned int r : active)
+        {
+          float t;
+          if (IntersectionUtil::intersects (rays[r], tri, bothSides, &t))
+          {
+            intersections[r].emplace_back ();
+            intersections[r].back ().update (t, rays[r].pointAt (t), tri.normal ());
+          }
+        }
+      });
+
+    for (std::vector<Intersection>& i : intersections)
+    {
+      sortIntersections (i);
+    }
+  }
+
   template <typename T, typename... Ts>
   bool intersectsT (const T& t, DynamicFaces& faces, const Ts&... args) const
   {
@@ -920,19 +1080,60 @@ struct DynamicMesh::Impl
     return faces.isEmpty () == false;
   }
 
-  template <typename T, typename... Ts>
-  bool containsOrIntersectsT (const T& t, DynamicFaces& faces, const Ts&... args) const
+  // the faces of partially intersected octree nodes are tested in packets
+  template <typename T>
+  bool containsOrIntersectsT (const T& t, DynamicFaces& faces) const
   {
-    this->octree.intersects (t, [this, &t, &faces, &args...](bool contains, unsigned int i) {
-      if (contains || IntersectionUtil::intersects (t, this->face (i), args...))
+    PrimTrianglePacket packet;
+
+    this->octree.intersectsBatched (t, [this, &t, &faces, &packet](
+                                         bool contains, const std::vector<unsigned int>& batch) {
+      if (contains)
       {
-        faces.insert (i);
+        faces.insert (batch);
         faces.commit ();
       }
+      else
+      {
+        this->intersectsPackets (t, batch, packet, faces);
+      }
     });
     return faces.isEmpty () == false;
   }
 
+  template <typename T>
+  void intersectsPackets (const T& t, const std::vector<unsigned int>& batch,
+                          PrimTrianglePacket& packet, DynamicFaces& faces) const
+  {
+    for (unsigned int first = 0; first < batch.size (); first += PrimTrianglePacket::maxSize)
+    {
+      const unsigned int end =
+        std::min (first + PrimTrianglePacket::maxSize, unsigned(batch.size ()));
+
+      packet.reset ();
+      for (unsigned int i = first; i < end; i++)
+      {
+        unsigned int i1, i2, i3;
+        this->vertexIndices (batch[i], i1, i2, i3);
+        packet.add (this->mesh.vertex (i1), this->mesh.vertex (i2), this->mesh.vertex (i3));
+      }
+
+      const unsigned int hits = IntersectionUtil::intersects (t, packet);
+
+      if (hits != 0)
+      {
+        for (unsigned int i = first; i < end; i++)
+        {
+          if (hits & (1u << (i - first)))
+          {
+            faces.insert (batch[i]);
+          }
+        }
+        faces.commit ();
+      }
+    }
+  }
+
   bool intersects (const PrimPlane& plane, DynamicFaces& faces) const
   {
     return this->intersectsT<PrimPlane> (plane, faces);
@@ -948,6 +1149,22 @@ struct DynamicMesh::Impl
     return this->containsOrIntersectsT<PrimAABox> (box, faces);
   }
 
+  bool intersects (const PrimFrustum& frustum) const
+  {
+    if (this->isEmpty ())
+    {
+      return false;
+    }
+    else if (IntersectionUtil::intersects (frustum, this->mesh.worldBounds ()))
+    {
+      return this->octree.intersects (frustum.transform (this->mesh.modelMatrix ()));
+    }
+    else
+    {
+      return false;
+    }
+  }
+
   float unsignedDistance (const glm::vec3& pos) const
   {
     return this->octree.distance (
@@ -957,7 +1174,14 @@ struct DynamicMesh::Impl
   void normalize ()
   {
     this->mesh.normalize ();
+
+    for (FaceData& d : this->faceData)
+    {
+      d.isDirty = true;
+    }
     this->octree.reset ();
+    this->chunks.reset ();
+    this->lod.reset ();
 
     this->forEachFace ([this](unsigned int i) { this->addFaceToOctree (i); });
   }
@@ -972,7 +1196,14 @@ struct DynamicMesh::Impl
 };
 
 DELEGATE_BIG4_COPY_SELF (DynamicMesh)
-DELEGATE1_CONSTRUCTOR_SELF (DynamicMesh, const Mesh&)
+
+DynamicMesh::DynamicMesh (const Mesh& mesh)
+  : impl (new Impl (this))
+{
+  // `fromMesh` buffers `this`, which requires `impl` to be initialized
+  this->impl->fromMesh (mesh);
+}
+
 DELEGATE_CONST (unsigned int, DynamicMesh, numVertices)
 DELEGATE_CONST (unsigned int, DynamicMesh, numFaces)
 DELEGATE_CONST (bool, DynamicMesh, isEmpty)
@@ -985,6 +1216,7 @@ DELEGATE4_CONST (void, DynamicMesh, vertexIndices, unsigned int, unsigned int&,
 DELEGATE1_CONST (PrimTriangle, DynamicMesh, face, unsigned int)
 DELEGATE1_CONST (const glm::vec3&, DynamicMesh, vertexNormal, unsigned int)
 DELEGATE1_CONST (glm::vec3, DynamicMesh, faceNormal, unsigned int)
+DELEGATE1_CONST (float, DynamicMesh, faceArea, unsigned int)
 DELEGATE1_CONST (const std::vector<unsigned int>&, DynamicMesh, adjacentFaces, unsigned int)
 GETTER_CONST (const Mesh&, DynamicMesh, mesh)
 DELEGATE1 (void, DynamicMesh, forEachVertex, const std::function<void(unsigned int)>&)
@@ -1009,15 +1241,17 @@ DELEGATE1_CONST (float, DynamicMesh, averageEdgeLengthSqr, unsigned int)
 DELEGATE2 (unsigned int, DynamicMesh, addVertex, const glm::vec3&, const glm::vec3&)
 DELEGATE3 (unsigned int, DynamicMesh, addFace, unsigned int, unsigned int, unsigned int)
 DELEGATE1 (void, DynamicMesh, deleteVertex, unsigned int)
+DELEGATE1 (void, DynamicMesh, deleteVertices, const std::vector<unsigned int>&)
 DELEGATE1 (void, DynamicMesh, deleteFace, unsigned int)
-DELEGATE2_MEMBER (void, DynamicMesh, vertex, mesh, unsigned int, const glm::vec3&)
+DELEGATE4 (void, DynamicMesh, replaceFace, unsigned int, unsigned int, unsigned int, unsigned int)
+DELEGATE2 (void, DynamicMesh, vertex, unsigned int, const glm::vec3&)
 DELEGATE2 (void, DynamicMesh, vertexNormal, unsigned int, const glm::vec3&)
 DELEGATE1 (void, DynamicMesh, setVertexNormal, unsigned int)
 DELEGATE (void, DynamicMesh, setAllNormals)
 DELEGATE (void, DynamicMesh, reset)
 DELEGATE1 (void, DynamicMesh, fromMesh, const Mesh&)
 DELEGATE1 (void, DynamicMesh, realignFace, unsigned int)
-DELEGATE1 (void, DynamicMesh, realignFaces, const DynamicFaces&)
+DELEGATE1 (unsigned int, DynamicMesh, realignFaces, const DynamicFaces&)
 DELEGATE (void, DynamicMesh, realignAllFaces)
 DELEGATE (void, DynamicMesh, sanitize)
 DELEGATE2 (void, DynamicMesh, prune, std::vector<unsigned int>*, std::vector<unsigned int>*)
@@ -1026,6 +1260,8 @@ DELEGATE2 (bool, DynamicMesh, pruneAndCheckConsistency, std::vector<unsigned int
 DELEGATE1 (bool, DynamicMesh, mirror, const PrimPlane&)
 DELEGATE (void, DynamicMesh, bufferData)
 DELEGATE1_CONST (void, DynamicMesh, render, Camera&)
+DELEGATE (void, DynamicMesh, updateProxies)
+DELEGATE2 (bool, DynamicMesh, renderProxy, Camera&, unsigned int)
 DELEGATE_MEMBER_CONST (const RenderMode&, DynamicMesh, renderMode, mesh)
 DELEGATE_MEMBER (RenderMode&, DynamicMesh, renderMode, mesh)
 
@@ -1034,6 +1270,10 @@ DELEGATE2 (bool, DynamicMesh, intersects, const PrimRay&, DynamicMeshIntersectio
 DELEGATE2_CONST (bool, DynamicMesh, intersects, const PrimPlane&, DynamicFaces&)
 DELEGATE2_CONST (bool, DynamicMesh, intersects, const PrimSphere&, DynamicFaces&)
 DELEGATE2_CONST (bool, DynamicMesh, intersects, const PrimAABox&, DynamicFaces&)
+DELEGATE1_CONST (bool, DynamicMesh, intersects, const PrimFrustum&)
+DELEGATE3_CONST (bool, DynamicMesh, intersectsAll, const PrimRay&, std::vector<Intersection>&, bool)
+DELEGATE3_CONST (void, DynamicMesh, intersectsAll, const std::vector<PrimRay>&,
+                 std::vector<std::vector<Intersection>>&, bool)
 DELEGATE1_CONST (float, DynamicMesh, unsignedDistance, const glm::vec3&)
 
 DELEGATE (void, DynamicMesh, normalize)
@@ -18,6 +18,7 @@ class DynamicMeshIntersection;
 class Intersection;
 class Mesh;
 class PrimAABox;
+class PrimFrustum;
 class PrimPlane;
 class PrimRay;
 class PrimSphere;
@@ -41,6 +42,7 @@ public:
   PrimTriangle     face (unsigned int) const;
   const glm::vec3& vertexNormal (unsigned int) const;
   glm::vec3        faceNormal (unsigned int) const;
+  float            faceArea (unsigned int) const;
   void findAdjacent (unsigned int, unsigned int, unsigned int&, unsigned int&, unsigned int&,
                      unsigned int&) const;
 
@@ -66,7 +68,9 @@ public:
   unsigned int addVertex (const glm::vec3&, const glm::vec3&);
   unsigned int addFace (unsigned int, unsigned int, unsigned int);
   void         deleteVertex (unsigned int);
+  void         deleteVertices (const std::vector<unsigned int>&);
   void         deleteFace (unsigned int);
+  void         replaceFace (unsigned int, unsigned int, unsigned int, unsigned int);
 
   void vertex (unsigned int, const glm::vec3&);
   void vertexNormal (unsigned int, const glm::vec3&);
@@ -76,7 +80,7 @@ public:
   void reset ();
   void fromMesh (const Mesh&);
   void realignFace (unsigned int);
-  void realignFaces (const DynamicFaces&);
+  unsigned int realignFaces (const DynamicFaces&);
   void realignAllFaces ();
   void sanitize ();
   void prune (std::vector<unsigned int>* = nullptr, std::vector<unsigned int>* = nullptr);
@@ -86,6 +90,8 @@ public:
   void bufferData ();
 
   void render (Camera&) const;
+  void updateProxies ();
+  bool renderProxy (Camera&, unsigned int);
 
   const RenderMode& renderMode () const;
   RenderMode&       renderMode ();
@@ -95,6 +101,10 @@ public:
   bool  intersects (const PrimPlane&, DynamicFaces&) const;
   bool  intersects (const PrimSphere&, DynamicFaces&) const;
   bool  intersects (const PrimAABox&, DynamicFaces&) const;
+  bool  intersects (const PrimFrustum&) const;
+  bool  intersectsAll (const PrimRay&, std::vector<Intersection>&, bool = false) const;
+  void  intersectsAll (const std::vector<PrimRay>&, std::vector<std::vector<Intersection>>&,
+                       bool = false) const;
   float unsignedDistance (const glm::vec3&) const;
 
   void               normalize ();
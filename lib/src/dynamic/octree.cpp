@@ -2,17 +2,22 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <functional>
 #include <glm/glm.hpp>
 #include <iostream>
+#include <numeric>
 #include <unordered_map>
 #include <unordered_set>
 #include "dynamic/octree.hpp"
 #include "intersection.hpp"
 #include "maybe.hpp"
 #include "primitive/aabox.hpp"
+#include "primitive/frustum.hpp"
 #include "primitive/plane.hpp"
+#include "primitive/ray.hpp"
 #include "primitive/sphere.hpp"
 #include "util.hpp"
 
@@ -245,6 +250,30 @@ namespace
       }
     }
 
+    template <typename T>
+    void containsOrIntersectsBatchedT (
+      const T& t, std::vector<unsigned int>& batch,
+      const DynamicOctree::ContainsIntersectionBatchCallback& f) const
+    {
+      const bool contains = t.contains (this->looseAABox);
+
+      if (contains || IntersectionUtil::intersects (t, this->looseAABox))
+      {
+        if (this->indices.empty () == false)
+        {
+          batch.assign (this->indices.begin (), this->indices.end ());
+          f (contains, batch);
+        }
+        for (unsigned int i = 0; i < 8; i++)
+        {
+          if (this->children[i])
+          {
+            this->children[i]->containsOrIntersectsBatchedT<T> (t, batch, f);
+          }
+        }
+      }
+    }
+
     template <typename T>
     void intersectsT (const T& t, const DynamicOctree::IntersectionCallback& f) const
     {
@@ -264,26 +293,90 @@ namespace
       }
     }
 
-    void intersects (const PrimRay& ray, float& distance,
-                     const DynamicOctree::RayIntersectionCallback& f) const
+    // `firstChild` is the index of the child that is nearest to the ray's origin, cf. `childIndex`
+    void intersects (const PrimRay& ray, unsigned int firstChild, float& distance,
+                     const DynamicOctree::RayIntersectionCallback& f,
+                     unsigned int* numVisitedNodes) const
     {
       float t;
       if (IntersectionUtil::intersects (ray, this->looseAABox, &t) && t < distance)
       {
+        if (numVisitedNodes)
+        {
+          (*numVisitedNodes)++;
+        }
         for (unsigned int index : this->indices)
         {
           distance = glm::min (f (index), distance);
         }
+        // visits children front to back, i.e. a child is visited after all children that are
+        // nearer to the ray's origin along each axis
+        for (unsigned int i = 0; i < 8; i++)
+        {
+          const unsigned int c = i ^ firstChild;
+
+          if (this->children[c])
+          {
+            this->children[c]->intersects (ray, firstChild, distance, f, numVisitedNodes);
+          }
+        }
+      }
+    }
+
+    // `hits[level]` are the indices of those rays of the packet that intersect the parent node.
+    // `hits` holds one buffer per level below the parent, which is reused by all nodes of a level.
+    // Buffers are accessed by index, because a deeper node may append a buffer to `hits`.
+    void intersects (const std::vector<PrimRay>& rays, std::vector<std::vector<unsigned int>>& hits,
+                     unsigned int level, const DynamicOctree::RayPacketCallback& f) const
+    {
+      if (hits.size () == level + 1)
+      {
+        hits.emplace_back ();
+      }
+      hits[level + 1].clear ();
+
+      for (unsigned int r : hits[level])
+      {
+        if (IntersectionUtil::intersects (rays[r], this->looseAABox, nullptr))
+        {
+          hits[level + 1].push_back (r);
+        }
+      }
+      if (hits[level + 1].empty () == false)
+      {
+        for (unsigned int index : this->indices)
+        {
+          f (hits[level + 1], index);
+        }
         for (unsigned int i = 0; i < 8; i++)
         {
           if (this->children[i])
           {
-            this->children[i]->intersects (ray, distance, f);
+            this->children[i]->intersects (rays, hits, level + 1, f);
           }
         }
       }
     }
 
+    bool intersects (const PrimFrustum& frustum) const
+    {
+      if (IntersectionUtil::intersects (frustum, this->looseAABox))
+      {
+        if (this->indices.empty () == false)
+        {
+          return true;
+        }
+        for (unsigned int i = 0; i < 8; i++)
+        {
+          if (this->children[i] && this->children[i]->intersects (frustum))
+          {
+            return true;
+          }
+        }
+      }
+      return false;
+    }
+
     void distance (PrimSphere& sphere, const DynamicOctree::DistanceCallback& getDistance) const
     {
       for (unsigned int i : this->indices)
@@ -372,6 +465,24 @@ namespace
   };
 }
 
+namespace
+{
+  // interleaves the bits of the position quantized to 10 bits per axis
+  uint32_t mortonKey (const glm::vec3& normalized)
+  {
+    const auto spread = [](float v) -> uint32_t {
+      uint32_t x = uint32_t (glm::clamp (v, 0.0f, 1.0f) * 1023.0f);
+
+      x = (x | (x << 16)) & 0x030000ff;
+      x = (x | (x << 8)) & 0x0300f00f;
+      x = (x | (x << 4)) & 0x030c30c3;
+      x = (x | (x << 2)) & 0x09249249;
+      return x;
+    };
+    return (spread (normalized.x) << 2) | (spread (normalized.y) << 1) | spread (normalized.z);
+  }
+}
+
 struct DynamicOctree::Impl
 {
   Child                         root;
@@ -494,6 +605,61 @@ struct DynamicOctree::Impl
     }
   }
 
+  // elements that left their node are removed first and then reinserted in Morton order of their
+  // positions, so that consecutive insertions descend along similar paths
+  unsigned int realignElements (const std::vector<unsigned int>& indices,
+                                const BoundsCallback&            getBounds)
+  {
+    assert (this->hasRoot ());
+
+    struct Migration
+    {
+      unsigned int index;
+      glm::vec3    position;
+      float        maxDimExtent;
+      uint32_t     key;
+    };
+    std::vector<Migration> migrations;
+
+    const glm::vec3 rootMin = this->root->center - glm::vec3 (this->root->width * 0.5f);
+    const float     rootWidth = this->root->width;
+
+    for (unsigned int index : indices)
+    {
+      assert (index < this->elementNodeMap.size ());
+      assert (this->elementNodeMap[index]);
+
+      glm::vec3 position;
+      float     maxDimExtent;
+      getBounds (index, position, maxDimExtent);
+
+      IndexOctreeNode* node = this->elementNodeMap[index];
+
+      if (node->approxContains (position, maxDimExtent) == false ||
+          node->insertIntoChild (maxDimExtent))
+      {
+        node->deleteElement (index);
+        this->elementNodeMap[index] = nullptr;
+
+        const glm::vec3 normalized = (position - rootMin) / rootWidth;
+        migrations.push_back (Migration{index, position, maxDimExtent, mortonKey (normalized)});
+      }
+    }
+
+    std::sort (migrations.begin (), migrations.end (),
+               [](const Migration& a, const Migration& b) { return a.key < b.key; });
+
+    for (const Migration& m : migrations)
+    {
+      this->addElement (m.index, m.position, m.maxDimExtent);
+    }
+    if (migrations.empty () == false)
+    {
+      this->shrinkRoot ();
+    }
+    return migrations.size ();
+  }
+
   void deleteElement (unsigned int index)
   {
     assert (index < this->elementNodeMap.size ());
@@ -646,12 +812,29 @@ struct DynamicOctree::Impl
   void render (Camera&) const { DILAY_IMPOSSIBLE }
 #endif
 
-  void intersects (const PrimRay& ray, const DynamicOctree::RayIntersectionCallback& f) const
+  void intersects (const PrimRay& ray, const DynamicOctree::RayIntersectionCallback& f,
+                   unsigned int* numVisitedNodes) const
   {
     if (this->hasRoot ())
     {
-      float distance = Util::maxFloat ();
-      return this->root->intersects (ray, distance, f);
+      const glm::vec3&   d = ray.direction ();
+      const unsigned int firstChild =
+        (d.x < 0.0f ? 4 : 0) + (d.y < 0.0f ? 2 : 0) + (d.z < 0.0f ? 1 : 0);
+      float              distance = Util::maxFloat ();
+
+      this->root->intersects (ray, firstChild, distance, f, numVisitedNodes);
+    }
+  }
+
+  void intersects (const std::vector<PrimRay>&             rays,
+                   const DynamicOctree::RayPacketCallback& f) const
+  {
+    if (this->hasRoot () && rays.empty () == false)
+    {
+      std::vector<std::vector<unsigned int>> hits (1, std::vector<unsigned int> (rays.size ()));
+      std::iota (hits[0].begin (), hits[0].end (), 0);
+
+      this->root->intersects (rays, hits, 0, f);
     }
   }
 
@@ -680,6 +863,34 @@ struct DynamicOctree::Impl
     }
   }
 
+  template <typename T>
+  void intersectsBatchedT (const T&                                                t,
+                           const DynamicOctree::ContainsIntersectionBatchCallback& f) const
+  {
+    if (this->hasRoot ())
+    {
+      std::vector<unsigned int> batch;
+      this->root->containsOrIntersectsBatchedT<T> (t, batch, f);
+    }
+  }
+
+  void intersectsBatched (const PrimSphere&                                       sphere,
+                          const DynamicOctree::ContainsIntersectionBatchCallback& f) const
+  {
+    this->intersectsBatchedT<PrimSphere> (sphere, f);
+  }
+
+  void intersectsBatched (const PrimAABox&                                        box,
+                          const DynamicOctree::ContainsIntersectionBatchCallback& f) const
+  {
+    this->intersectsBatchedT<PrimAABox> (box, f);
+  }
+
+  bool intersects (const PrimFrustum& frustum) const
+  {
+    return this->hasRoot () && this->root->intersects (frustum);
+  }
+
   float distance (const glm::vec3& p, const DistanceCallback& getDistance) const
   {
     assert (this->hasRoot ());
@@ -716,20 +927,29 @@ DELEGATE_CONST (bool, DynamicOctree, hasRoot)
 DELEGATE2 (void, DynamicOctree, setupRoot, const glm::vec3&, float)
 DELEGATE3 (void, DynamicOctree, addElement, unsigned int, const glm::vec3&, float)
 DELEGATE3 (void, DynamicOctree, realignElement, unsigned int, const glm::vec3&, float)
+DELEGATE2 (unsigned int, DynamicOctree, realignElements, const std::vector<unsigned int>&,
+           const DynamicOctree::BoundsCallback&)
 DELEGATE1 (void, DynamicOctree, deleteElement, unsigned int)
 DELEGATE (void, DynamicOctree, deleteEmptyChildren)
 DELEGATE1 (void, DynamicOctree, updateIndices, const std::vector<unsigned int>&)
 DELEGATE (void, DynamicOctree, shrinkRoot)
 DELEGATE (void, DynamicOctree, reset)
 DELEGATE1_CONST (void, DynamicOctree, render, Camera&)
-DELEGATE2_CONST (void, DynamicOctree, intersects, const PrimRay&,
-                 const DynamicOctree::RayIntersectionCallback&)
+DELEGATE3_CONST (void, DynamicOctree, intersects, const PrimRay&,
+                 const DynamicOctree::RayIntersectionCallback&, unsigned int*)
+DELEGATE2_CONST (void, DynamicOctree, intersects, const std::vector<PrimRay>&,
+                 const DynamicOctree::RayPacketCallback&)
 DELEGATE2_CONST (void, DynamicOctree, intersects, const PrimPlane&,
                  const DynamicOctree::IntersectionCallback&)
 DELEGATE2_CONST (void, DynamicOctree, intersects, const PrimSphere&,
                  const DynamicOctree::ContainsIntersectionCallback&)
 DELEGATE2_CONST (void, DynamicOctree, intersects, const PrimAABox&,
                  const DynamicOctree::ContainsIntersectionCallback&)
+DELEGATE2_CONST (void, DynamicOctree, intersectsBatched, const PrimSphere&,
+                 const DynamicOctree::ContainsIntersectionBatchCallback&)
+DELEGATE2_CONST (void, DynamicOctree, intersectsBatched, const PrimAABox&,
+                 const DynamicOctree::ContainsIntersectionBatchCallback&)
+DELEGATE1_CONST (bool, DynamicOctree, intersects, const PrimFrustum&)
 DELEGATE2_CONST (float, DynamicOctree, distance, const glm::vec3&,
                  const DynamicOctree::DistanceCallback&)
 DELEGATE_CONST (void, DynamicOctree, printStatistics)
@@ -12,6 +12,7 @@
 
 class Camera;
 class PrimAABox;
+class PrimFrustum;
 class PrimPlane;
 class PrimRay;
 class PrimSphere;
@@ -21,27 +22,42 @@ class DynamicOctree
 public:
   DECLARE_BIG4_EXPLICIT_COPY (DynamicOctree)
 
-  typedef std::function<void(unsigned int)>       IntersectionCallback;
-  typedef std::function<float(unsigned int)>      RayIntersectionCallback;
-  typedef std::function<void(bool, unsigned int)> ContainsIntersectionCallback;
-  typedef std::function<float(unsigned int)>      DistanceCallback;
-
-  bool  hasRoot () const;
-  void  setupRoot (const glm::vec3&, float);
-  void  addElement (unsigned int, const glm::vec3&, float);
-  void  realignElement (unsigned int, const glm::vec3&, float);
-  void  deleteElement (unsigned int);
-  void  deleteEmptyChildren ();
-  void  updateIndices (const std::vector<unsigned int>&);
-  void  shrinkRoot ();
-  void  reset ();
-  void  render (Camera&) const;
-  void  intersects (const PrimRay&, const RayIntersectionCallback&) const;
-  void  intersects (const PrimPlane&, const IntersectionCallback&) const;
-  void  intersects (const PrimSphere&, const ContainsIntersectionCallback&) const;
-  void  intersects (const PrimAABox&, const ContainsIntersectionCallback&) const;
-  float distance (const glm::vec3&, const DistanceCallback&) const;
-  void  printStatistics () const;
+  typedef std::function<void(unsigned int)>                     IntersectionCallback;
+  typedef std::function<float(unsigned int)>                    RayIntersectionCallback;
+  typedef std::function<void(bool, unsigned int)>               ContainsIntersectionCallback;
+  typedef std::function<float(unsigned int)>                    DistanceCallback;
+  typedef std::function<void(unsigned int, glm::vec3&, float&)> BoundsCallback;
+
+  // called with the rays of a packet that intersect the node of an element
+  typedef std::function<void(const std::vector<unsigned int>&, unsigned int)> RayPacketCallback;
+
+  // called once per node with all of its elements
+  typedef std::function<void(bool, const std::vector<unsigned int>&)>
+    ContainsIntersectionBatchCallback;
+
+  bool         hasRoot () const;
+  void         setupRoot (const glm::vec3&, float);
+  void         addElement (unsigned int, const glm::vec3&, float);
+  void         realignElement (unsigned int, const glm::vec3&, float);
+  unsigned int realignElements (const std::vector<unsigned int>&, const BoundsCallback&);
+  void         deleteElement (unsigned int);
+  void         deleteEmptyChildren ();
+  void         updateIndices (const std::vector<unsigned int>&);
+  void         shrinkRoot ();
+  void         reset ();
+  void         render (Camera&) const;
+  void         intersects (const PrimRay&, const RayIntersectionCallback&,
+                           unsigned int* = nullptr) const;
+  void         intersects (const std::vector<PrimRay>&, const RayPacketCallback&) const;
+  void         intersects (const PrimPlane&, const IntersectionCallback&) const;
+  void         intersects (const PrimSphere&, const ContainsIntersectionCallback&) const;
+  void         intersects (const PrimAABox&, const ContainsIntersectionCallback&) const;
+  void         intersectsBatched (const PrimSphere&,
+                                  const ContainsIntersectionBatchCallback&) const;
+  void         intersectsBatched (const PrimAABox&, const ContainsIntersectionBatchCallback&) const;
+  bool         intersects (const PrimFrustum&) const;
+  float        distance (const glm::vec3&, const DistanceCallback&) const;
+  void         printStatistics () const;
 
 private:
   IMPLEMENTATION
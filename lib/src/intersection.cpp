@@ -8,9 +8,11 @@
 #include "primitive/aabox.hpp"
 #include "primitive/cone.hpp"
 #include "primitive/cylinder.hpp"
+#include "primitive/frustum.hpp"
 #include "primitive/plane.hpp"
 #include "primitive/ray.hpp"
 #include "primitive/sphere.hpp"
+#include "primitive/triangle-packet.hpp"
 #include "primitive/triangle.hpp"
 #include "util.hpp"
 
@@ -490,3 +492,162 @@ bool IntersectionUtil::intersects (const PrimAABox& box, const PrimTriangle& tri
     return IntersectionUtil::intersects (PrimPlane (tri.vertex1 (), tri.normal ()), box);
   }
 }
+
+bool IntersectionUtil::intersects (const PrimFrustum& frustum, const PrimAABox& box)
+{
+  const glm::vec3& max = box.maximum ();
+  const glm::vec3& min = box.minimum ();
+
+  for (const glm::vec4& plane : frustum.planes ())
+  {
+    const glm::vec3 p = glm::vec3 (plane.x >= 0.0f ? max.x : min.x, plane.y >= 0.0f ? max.y : min.y,
+                                   plane.z >= 0.0f ? max.z : min.z);
+
+    if (glm::dot (glm::vec3 (plane), p) + plane.w < 0.0f)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+namespace
+{
+  unsigned int packetMask (const PrimTrianglePacket& tris,
+                           const int (&hits)[PrimTrianglePacket::maxSize])
+  {
+    unsigned int mask = 0;
+
+    for (unsigned int i = 0; i < PrimTrianglePacket::maxSize; i++)
+    {
+      mask |= unsigned(hits[i]) << i;
+    }
+    return mask & tris.mask ();
+  }
+}
+
+// lane-wise version of `intersects (const PrimSphere&, const PrimTriangle&)`
+unsigned int IntersectionUtil::intersects (const PrimSphere& sphere, const PrimTrianglePacket& tris)
+{
+  const float rr = sphere.radius () * sphere.radius ();
+  int         hits[PrimTrianglePacket::maxSize];
+
+  for (unsigned int i = 0; i < PrimTrianglePacket::maxSize; i++)
+  {
+    const glm::vec3 A = tris.vertex (0, i) - sphere.center ();
+    const glm::vec3 B = tris.vertex (1, i) - sphere.center ();
+    const glm::vec3 C = tris.vertex (2, i) - sphere.center ();
+
+    const glm::vec3 V = glm::cross (B - A, C - A);
+    const float     d = glm::dot (A, V);
+    const float     e = glm::dot (V, V);
+    const bool      sep1 = d * d > rr * e;
+
+    const float aa = glm::dot (A, A);
+    const float ab = glm::dot (A, B);
+    const float ac = glm::dot (A, C);
+    const float bb = glm::dot (B, B);
+    const float bc = glm::dot (B, C);
+    const float cc = glm::dot (C, C);
+    const bool  sep2 = (aa > rr) & (ab > aa) & (ac > aa);
+    const bool  sep3 = (bb > rr) & (ab > bb) & (bc > bb);
+    const bool  sep4 = (cc > rr) & (ac > cc) & (bc > cc);
+
+    const glm::vec3 AB = B - A;
+    const glm::vec3 BC = C - B;
+    const glm::vec3 CA = A - C;
+
+    const float d1 = ab - aa;
+    const float d2 = bc - bb;
+    const float d3 = ac - cc;
+    const float e1 = glm::dot (AB, AB);
+    const float e2 = glm::dot (BC, BC);
+    const float e3 = glm::dot (CA, CA);
+
+    const glm::vec3 Q1 = (A * e1) - (d1 * AB);
+    const glm::vec3 Q2 = (B * e2) - (d2 * BC);
+    const glm::vec3 Q3 = (C * e3) - (d3 * CA);
+    const glm::vec3 QC = (C * e1) - Q1;
+    const glm::vec3 QA = (A * e2) - Q2;
+    const glm::vec3 QB = (B * e3) - Q3;
+
+    const bool sep5 = (glm::dot (Q1, Q1) > rr * e1 * e1) & (glm::dot (Q1, QC) > 0.0f);
+    const bool sep6 = (glm::dot (Q2, Q2) > rr * e2 * e2) & (glm::dot (Q2, QA) > 0.0f);
+    const bool sep7 = (glm::dot (Q3, Q3) > rr * e3 * e3) & (glm::dot (Q3, QB) > 0.0f);
+
+    hits[i] = (sep1 | sep2 | sep3 | sep4 | sep5 | sep6 | sep7) == false;
+  }
+  return packetMask (tris, hits);
+}
+
+// lane-wise version of `intersects (const PrimAABox&, const PrimTriangle&)`: the box's axes are
+// tested first, the remaining axes are tested only if some triangle overlaps the box along them.
+// The final plane test compares the triangle's projected distance from the box's center with the
+// box's projected radius.
+unsigned int IntersectionUtil::intersects (const PrimAABox& box, const PrimTrianglePacket& tris)
+{
+  const glm::vec3 c = box.center ();
+  const glm::vec3 hw = box.halfWidth ();
+  int             hits[PrimTrianglePacket::maxSize];
+
+  for (unsigned int i = 0; i < PrimTrianglePacket::maxSize; i++)
+  {
+    const glm::vec3 v0 = tris.vertex (0, i) - c;
+    const glm::vec3 v1 = tris.vertex (1, i) - c;
+    const glm::vec3 v2 = tris.vertex (2, i) - c;
+    const glm::vec3 min = glm::min (v0, glm::min (v1, v2));
+    const glm::vec3 max = glm::max (v0, glm::max (v1, v2));
+
+    const bool sep1 = (min.x > hw.x) | (max.x < -hw.x);
+    const bool sep2 = (min.y > hw.y) | (max.y < -hw.y);
+    const bool sep3 = (min.z > hw.z) | (max.z < -hw.z);
+
+    hits[i] = (sep1 | sep2 | sep3) == false;
+  }
+
+  if (packetMask (tris, hits) == 0)
+  {
+    return 0;
+  }
+
+  for (unsigned int i = 0; i < PrimTrianglePacket::maxSize; i++)
+  {
+    const glm::vec3 v0 = tris.vertex (0, i) - c;
+    const glm::vec3 v1 = tris.vertex (1, i) - c;
+    const glm::vec3 v2 = tris.vertex (2, i) - c;
+    const glm::vec3 e0 = v1 - v0;
+    const glm::vec3 e1 = v2 - v1;
+    const glm::vec3 e2 = v0 - v2;
+
+    auto sepAxis = [&v0, &v1, &v2, &hw](const glm::vec3& a) -> bool {
+      const float radius = glm::dot (hw, glm::abs (a));
+      const float p0 = glm::dot (a, v0);
+      const float p1 = glm::dot (a, v1);
+      const float p2 = glm::dot (a, v2);
+      const float min = glm::min (p0, glm::min (p1, p2));
+      const float max = glm::max (p0, glm::max (p1, p2));
+
+      return (min > radius) | (max < -radius);
+    };
+
+    const bool sep4 = sepAxis (glm::vec3 (0.0f, -e0.z, e0.y));
+    const bool sep5 = sepAxis (glm::vec3 (0.0f, -e1.z, e1.y));
+    const bool sep6 = sepAxis (glm::vec3 (0.0f, -e2.z, e2.y));
+
+    const bool sep7 = sepAxis (glm::vec3 (e0.z, 0.0f, -e0.x));
+    const bool sep8 = sepAxis (glm::vec3 (e1.z, 0.0f, -e1.x));
+    const bool sep9 = sepAxis (glm::vec3 (e2.z, 0.0f, -e2.x));
+
+    const bool sep10 = sepAxis (glm::vec3 (-e0.y, e0.x, 0.0f));
+    const bool sep11 = sepAxis (glm::vec3 (-e1.y, e1.x, 0.0f));
+    const bool sep12 = sepAxis (glm::vec3 (-e2.y, e2.x, 0.0f));
+
+    const glm::vec3 n = glm::cross (e0, e1);
+    const float     s = glm::dot (n, v0);
+    const float     r = glm::dot (hw, glm::abs (n));
+    const bool      sep13 = s * s >= r * r;
+
+    hits[i] &= (sep4 | sep5 | sep6 | sep7 | sep8 | sep9 | sep10 | sep11 | sep12 | sep13) == false;
+  }
+  return packetMask (tris, hits);
+}
@@ -10,10 +10,12 @@
 class PrimAABox;
 class PrimCone;
 class PrimCylinder;
+class PrimFrustum;
 class PrimPlane;
 class PrimRay;
 class PrimSphere;
 class PrimTriangle;
+class PrimTrianglePacket;
 
 class Intersection
 {
@@ -55,6 +57,11 @@ namespace IntersectionUtil
   bool intersects (const PrimCone&, const glm::vec3&);
   bool intersects (const PrimAABox&, const PrimAABox&);
   bool intersects (const PrimAABox&, const PrimTriangle&);
+  bool intersects (const PrimFrustum&, const PrimAABox&);
+
+  // return a bitmask of the intersecting triangles of a packet
+  unsigned int intersects (const PrimSphere&, const PrimTrianglePacket&);
+  unsigned int intersects (const PrimAABox&, const PrimTrianglePacket&);
 }
 
 #endif
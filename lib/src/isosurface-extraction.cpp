@@ -3,12 +3,10 @@
  * Use and redistribute under the terms of the GNU General Public License
  */
 #include <glm/glm.hpp>
-#include <glm/gtx/norm.hpp>
 #include <thread>
 #include <vector>
 #include "distance.hpp"
 #include "dynamic/mesh.hpp"
-#include "intersection.hpp"
 #include "isosurface-extraction.hpp"
 #include "isosurface-extraction/grid.hpp"
 #include "mesh.hpp"
@@ -107,59 +105,52 @@ namespace
   {
     assert (params.getIntersection);
 
-    std::vector<float>& samples = params.grid.samples ();
+    std::vector<float>&             samples = params.grid.samples ();
+    const glm::vec3                 dir (0.0f, 0.0f, 1.0f);
+    std::vector<PrimRay>            rays;
+    std::vector<std::vector<float>> distances;
+
+    rays.reserve (params.grid.numSamples ().x);
 
-    for (unsigned int y = 0; y < params.grid.numSamples ().y; y++)
+    // the rays of a row are parallel and adjacent, i.e. they are intersected as one packet
+    for (unsigned int y = threadId; y < params.grid.numSamples ().y; y += numThreads)
     {
+      rays.clear ();
       for (unsigned int x = 0; x < params.grid.numSamples ().x; x++)
       {
-        if (params.grid.sampleIndex (x, y, 0) % numThreads == threadId)
-        {
-          const glm::vec3 dir (0.0f, 0.0f, 1.0f);
-          bool            inside = false;
-          unsigned int    z = 0;
-          Intersection    intersection;
-          PrimRay         ray (params.grid.samplePos (x, y, 0.0f) - (dir * Util::epsilon ()), dir);
-
-          while (true)
-          {
-            intersection.reset ();
-            IsosurfaceExtraction::Intersection i = (*params.getIntersection) (ray, intersection);
-
-            if (i == IsosurfaceExtraction::Intersection::None)
-            {
-              break;
-            }
-            else
-            {
-              const float d2 = intersection.distance () * intersection.distance ();
-
-              while (glm::distance2 (params.grid.samplePos (x, y, z), ray.origin ()) < d2)
-              {
-                const unsigned int index = params.grid.sampleIndex (x, y, z);
+        rays.emplace_back (params.grid.samplePos (x, y, 0.0f) - (dir * Util::epsilon ()), dir);
+      }
 
-                assert (samples[index] == Util::maxFloat ());
-                samples[index] = inside ? markInside : markOutside;
+      (*params.getIntersection) (rays, distances);
+      assert (distances.size () == rays.size ());
 
-                z++;
-              }
-              ray.origin (intersection.position () + (dir * Util::epsilon ()));
-
-              if (i == IsosurfaceExtraction::Intersection::Sample)
-              {
-                inside = not inside;
-              }
-            }
-          }
+      for (unsigned int x = 0; x < params.grid.numSamples ().x; x++)
+      {
+        const float  originZ = rays[x].origin ().z;
+        bool         inside = false;
+        unsigned int z = 0;
 
-          assert (z < params.grid.numSamples ().z - 1);
-          for (; z < params.grid.numSamples ().z; z++)
+        for (float d : distances[x])
+        {
+          while (params.grid.samplePos (x, y, z).z - originZ < d)
           {
             const unsigned int index = params.grid.sampleIndex (x, y, z);
 
             assert (samples[index] == Util::maxFloat ());
-            samples[index] = markOutside;
+            samples[index] = inside ? markInside : markOutside;
+
+            z++;
           }
+          inside = not inside;
+        }
+
+        assert (z < params.grid.numSamples ().z - 1);
+        for (; z < params.grid.numSamples ().z; z++)
+        {
+          const unsigned int index = params.grid.sampleIndex (x, y, z);
+
+          assert (samples[index] == Util::maxFloat ());
+          samples[index] = markOutside;
         }
       }
     }
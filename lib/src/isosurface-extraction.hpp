@@ -7,23 +7,20 @@
 
 #include <functional>
 #include <glm/fwd.hpp>
+#include <vector>
 
 class DynamicMesh;
-class Intersection;
 class PrimAABox;
 class PrimRay;
 
 namespace IsosurfaceExtraction
 {
-  enum class Intersection
-  {
-    None,
-    Sample,
-    Continue
-  };
+  typedef std::function<float(const glm::vec3&)> DistanceCallback;
 
-  typedef std::function<float(const glm::vec3&)>                        DistanceCallback;
-  typedef std::function<Intersection (const PrimRay&, ::Intersection&)> IntersectionCallback;
+  // computes for each ray of a row of parallel rays the ascending distances at which the ray
+  // enters or leaves the volume
+  typedef std::function<void(const std::vector<PrimRay>&, std::vector<std::vector<float>>&)>
+    IntersectionCallback;
 
   void extract (const DistanceCallback&, const IntersectionCallback&, const PrimAABox&, float,
                 DynamicMesh&);
@@ -82,6 +82,21 @@ namespace
       return this->data[index];
     }
 
+    // sets or appends a value and marks it for buffering only if it differs from the old one
+    void update (unsigned int index, const T& value)
+    {
+      assert (index <= this->numElements ());
+
+      if (index == this->numElements ())
+      {
+        this->add (value);
+      }
+      else if (this->data[index] != value)
+      {
+        this->set (index, value);
+      }
+    }
+
     void bufferData (unsigned int target)
     {
       if (this->id.isValid () == false)
@@ -132,12 +147,37 @@ struct Mesh::Impl
 
   RenderMode renderMode;
 
+  // a vertex stream with a copy of the vertex data per index, i.e. per corner of a triangle,
+  // that is rendered if wireframes are drawn without a geometry shader, cf. `bufferCorners`
+  mutable BufferedData<glm::vec3> cornerVertices;
+  mutable BufferedData<glm::vec3> cornerNormals;
+  mutable BufferedData<glm::vec3> cornerBarycentrics;
+  mutable bool                    cornersAreDirty;
+
+  // while corners are not dirty, changes are tracked per vertex and per corner, and the corners
+  // of each vertex are linked in a list, such that only changed corners are updated
+  mutable std::vector<unsigned int> firstCorner;
+  mutable std::vector<unsigned int> nextCorner;
+  mutable std::vector<unsigned int> dirtyVertices;
+  mutable std::vector<unsigned int> dirtyCorners;
+
+  // cached bounds, cf. `bounds`, `worldBounds`
+  mutable bool      hasBounds;
+  mutable glm::vec3 minimum;
+  mutable glm::vec3 maximum;
+  mutable bool      hasWorldBounds;
+  mutable glm::vec3 worldMinimum;
+  mutable glm::vec3 worldMaximum;
+
   Impl ()
     : scalingMatrix (glm::mat4x4 (1.0f))
     , rotationMatrix (glm::mat4x4 (1.0f))
     , translationMatrix (glm::mat4x4 (1.0f))
     , color (Color::White ())
     , wireframeColor (Color::Black ())
+    , cornersAreDirty (true)
+    , hasBounds (false)
+    , hasWorldBounds (false)
   {
     this->renderMode.smoothShading (true);
   }
@@ -160,13 +200,29 @@ struct Mesh::Impl
     this->color = source.impl->color;
     this->wireframeColor = source.impl->wireframeColor;
     this->renderMode = source.impl->renderMode;
+    this->hasWorldBounds = false;
   }
 
-  unsigned int addIndex (unsigned int i) { return this->indices.add (i); }
+  unsigned int addIndex (unsigned int i)
+  {
+    const unsigned int c = this->indices.add (i);
+
+    if (this->cornersAreDirty == false)
+    {
+      this->nextCorner.push_back (Util::invalidIndex ());
+      this->linkCorner (c, i);
+      this->cornerChanged (c);
+    }
+    return c;
+  }
 
   void reserveIndices (unsigned int n) { this->indices.reserve (n); }
 
-  void shrinkIndices (unsigned int n) { this->indices.shrink (n); }
+  void shrinkIndices (unsigned int n)
+  {
+    this->indices.shrink (n);
+    this->cornersAreDirty = true;
+  }
 
   unsigned int addVertex (const glm::vec3& v) { return this->addVertex (v, glm::vec3 (0.0f)); }
 
@@ -176,8 +232,15 @@ struct Mesh::Impl
     assert (Util::isNaN (n) == false);
     assert (this->vertices.numElements () == this->normals.numElements ());
 
+    if (this->hasBounds)
+    {
+      this->extendBounds (v);
+    }
     this->vertices.add (v);
-    return this->normals.add (n);
+
+    const unsigned int i = this->normals.add (n);
+    this->vertexChanged (i);
+    return i;
   }
 
   void reserveVertices (unsigned int n)
@@ -190,29 +253,192 @@ struct Mesh::Impl
   {
     this->vertices.shrink (n);
     this->normals.shrink (n);
+    this->resetBounds ();
+    this->cornersAreDirty = true;
   }
 
-  void index (unsigned int i, unsigned int index) { this->indices.set (i, index); }
+  void index (unsigned int i, unsigned int index)
+  {
+    if (this->cornersAreDirty == false)
+    {
+      this->unlinkCorner (i, this->index (i));
+      this->linkCorner (i, index);
+      this->cornerChanged (i);
+    }
+    this->indices.set (i, index);
+  }
 
   void vertex (unsigned int i, const glm::vec3& v)
   {
     assert (Util::isNaN (v) == false);
+
+    if (this->hasBounds)
+    {
+      const glm::vec3& old = this->vertices.get (i);
+
+      if (glm::any (glm::equal (old, this->minimum)) || glm::any (glm::equal (old, this->maximum)))
+      {
+        this->resetBounds ();
+      }
+      else
+      {
+        this->extendBounds (v);
+      }
+    }
     this->vertices.set (i, v);
+    this->vertexChanged (i);
   }
 
   void normal (unsigned int i, const glm::vec3& n)
   {
     assert (Util::isNaN (n) == false);
     this->normals.set (i, n);
+    this->vertexChanged (i);
   }
 
   void bufferData ()
   {
-    this->vertices.bufferData (OpenGL::ArrayBuffer ());
     this->indices.bufferData (OpenGL::ElementArrayBuffer ());
-    this->normals.bufferData (OpenGL::ArrayBuffer ());
+    this->bufferVertexData ();
 
     OpenGL::glBindBuffer (OpenGL::ElementArrayBuffer (), 0);
+  }
+
+  void bufferVertexData ()
+  {
+    this->vertices.bufferData (OpenGL::ArrayBuffer ());
+    this->normals.bufferData (OpenGL::ArrayBuffer ());
+
+    OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), 0);
+  }
+
+  void linkCorner (unsigned int c, unsigned int v) const
+  {
+    if (v >= this->firstCorner.size ())
+    {
+      this->firstCorner.resize (v + 1, Util::invalidIndex ());
+    }
+    this->nextCorner[c] = this->firstCorner[v];
+    this->firstCorner[v] = c;
+  }
+
+  void unlinkCorner (unsigned int c, unsigned int v)
+  {
+    unsigned int* link = &this->firstCorner[v];
+
+    while (*link != c)
+    {
+      link = &this->nextCorner[*link];
+    }
+    *link = this->nextCorner[c];
+  }
+
+  // if more changes are tracked than there are corners, all corners are updated instead
+  void vertexChanged (unsigned int v)
+  {
+    if (this->cornersAreDirty == false)
+    {
+      this->dirtyVertices.push_back (v);
+      this->limitDirtyCorners ();
+    }
+  }
+
+  void cornerChanged (unsigned int c)
+  {
+    this->dirtyCorners.push_back (c);
+    this->limitDirtyCorners ();
+  }
+
+  void limitDirtyCorners ()
+  {
+    if (this->dirtyVertices.size () + this->dirtyCorners.size () > this->numIndices ())
+    {
+      this->cornersAreDirty = true;
+      this->dirtyVertices.clear ();
+      this->dirtyCorners.clear ();
+    }
+  }
+
+  void updateCorner (unsigned int c) const
+  {
+    const unsigned int v = this->index (c);
+
+    if (v < this->numVertices ())
+    {
+      this->cornerVertices.update (c, this->vertex (v));
+      this->cornerNormals.update (c, this->normal (v));
+    }
+    else
+    {
+      this->cornerVertices.update (c, glm::vec3 (0.0f));
+      this->cornerNormals.update (c, glm::vec3 (0.0f));
+    }
+
+    if (c == this->cornerBarycentrics.numElements ())
+    {
+      glm::vec3 barycentric (0.0f);
+      barycentric[c % 3] = 1.0f;
+      this->cornerBarycentrics.add (barycentric);
+    }
+  }
+
+  // corners are updated lazily, so that meshes without wireframe do not pay for them
+  void bufferCorners () const
+  {
+    const unsigned int n = this->numIndices ();
+
+    if (this->cornersAreDirty || this->cornerVertices.id.isValid () == false)
+    {
+      if (this->cornerVertices.numElements () > n)
+      {
+        this->cornerVertices.shrink (n);
+        this->cornerNormals.shrink (n);
+        this->cornerBarycentrics.shrink (n);
+      }
+      this->firstCorner.assign (this->numVertices (), Util::invalidIndex ());
+      this->nextCorner.assign (n, Util::invalidIndex ());
+
+      for (unsigned int c = 0; c < n; c++)
+      {
+        this->updateCorner (c);
+        this->linkCorner (c, this->index (c));
+      }
+      this->cornersAreDirty = false;
+    }
+    else if (this->dirtyVertices.empty () && this->dirtyCorners.empty () &&
+             this->cornerVertices.numElements () == n)
+    {
+      return;
+    }
+    else
+    {
+      for (unsigned int c = this->cornerVertices.numElements (); c < n; c++)
+      {
+        this->updateCorner (c);
+      }
+      for (unsigned int v : this->dirtyVertices)
+      {
+        if (v < this->firstCorner.size ())
+        {
+          for (unsigned int c = this->firstCorner[v]; c != Util::invalidIndex ();
+               c = this->nextCorner[c])
+          {
+            this->updateCorner (c);
+          }
+        }
+      }
+      for (unsigned int c : this->dirtyCorners)
+      {
+        this->updateCorner (c);
+      }
+    }
+    this->dirtyVertices.clear ();
+    this->dirtyCorners.clear ();
+
+    this->cornerVertices.bufferData (OpenGL::ArrayBuffer ());
+    this->cornerNormals.bufferData (OpenGL::ArrayBuffer ());
+    this->cornerBarycentrics.bufferData (OpenGL::ArrayBuffer ());
+
     OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), 0);
   }
 
@@ -231,35 +457,39 @@ struct Mesh::Impl
     camera.setModelViewProjection (this->modelMatrix (), this->modelNormalMatrix (), noZoom);
   }
 
+  void bindAttribute (unsigned int index, const BufferedData<glm::vec3>& data) const
+  {
+    OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), data.id.id ());
+    OpenGL::glEnableVertexAttribArray (index);
+    OpenGL::glVertexAttribPointer (index, 3, OpenGL::Float (), false, 0, 0);
+  }
+
   void renderBegin (Camera& camera) const
   {
-    if (this->renderMode.renderWireframe () && OpenGL::hasGeometryShader () == false)
-    {
-      RenderMode nonWireframeRenderMode (this->renderMode);
-      nonWireframeRenderMode.renderWireframe (false);
+    const bool useCorners = this->renderMode.renderBarycentricWireframe ();
 
-      camera.renderer ().setProgram (nonWireframeRenderMode);
-    }
-    else
+    if (useCorners)
     {
-      camera.renderer ().setProgram (this->renderMode);
+      this->bufferCorners ();
     }
+    camera.renderer ().setProgram (this->renderMode);
     camera.renderer ().setColor (this->color);
     camera.renderer ().setWireframeColor (this->wireframeColor);
 
     this->setModelMatrix (camera, this->renderMode.cameraRotationOnly ());
 
-    OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), this->vertices.id.id ());
-    OpenGL::glEnableVertexAttribArray (OpenGL::PositionIndex);
-    OpenGL::glVertexAttribPointer (OpenGL::PositionIndex, 3, OpenGL::Float (), false, 0, 0);
+    this->bindAttribute (OpenGL::PositionIndex,
+                         useCorners ? this->cornerVertices : this->vertices);
 
     OpenGL::glBindBuffer (OpenGL::ElementArrayBuffer (), this->indices.id.id ());
 
     if (this->renderMode.smoothShading ())
     {
-      OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), this->normals.id.id ());
-      OpenGL::glEnableVertexAttribArray (OpenGL::NormalIndex);
-      OpenGL::glVertexAttribPointer (OpenGL::NormalIndex, 3, OpenGL::Float (), false, 0, 0);
+      this->bindAttribute (OpenGL::NormalIndex, useCorners ? this->cornerNormals : this->normals);
+    }
+    if (useCorners)
+    {
+      this->bindAttribute (OpenGL::BarycentricIndex, this->cornerBarycentrics);
     }
     OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), 0);
 
@@ -273,6 +503,7 @@ struct Mesh::Impl
   {
     OpenGL::glDisableVertexAttribArray (OpenGL::PositionIndex);
     OpenGL::glDisableVertexAttribArray (OpenGL::NormalIndex);
+    OpenGL::glDisableVertexAttribArray (OpenGL::BarycentricIndex);
     OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), 0);
     OpenGL::glBindBuffer (OpenGL::ElementArrayBuffer (), 0);
     OpenGL::glEnable (OpenGL::DepthTest ());
@@ -280,22 +511,25 @@ struct Mesh::Impl
 
   void render (Camera& camera) const
   {
-    this->renderBegin (camera);
-
-    OpenGL::glDrawElements (OpenGL::Triangles (), this->numIndices (), OpenGL::UnsignedInt (),
-                            nullptr);
-
-    if (this->renderMode.renderWireframe () && OpenGL::hasGeometryShader () == false)
-    {
-      camera.renderer ().setColor (this->wireframeColor);
-      OpenGL::glPolygonMode (OpenGL::FrontAndBack (), OpenGL::Line ());
-
-      OpenGL::glDrawElements (OpenGL::Triangles (), this->numIndices (), OpenGL::UnsignedInt (),
-                              nullptr);
-
-      OpenGL::glPolygonMode (OpenGL::FrontAndBack (), OpenGL::Fill ());
-    }
+    this->render (camera, [this]() {
+      if (this->renderMode.renderBarycentricWireframe ())
+      {
+        OpenGL::glDrawArrays (OpenGL::Triangles (), 0, this->numIndices ());
+      }
+      else
+      {
+        OpenGL::glDrawElements (OpenGL::Triangles (), this->numIndices (), OpenGL::UnsignedInt (),
+                                nullptr);
+      }
+    });
+  }
 
+  // if `renderMode.renderBarycentricWireframe ()` holds, `draw` must address corners, i.e. the
+  // positions of vertex indices in `indices`, instead of vertices
+  void render (Camera& camera, const std::function<void()>& draw) const
+  {
+    this->renderBegin (camera);
+    draw ();
     this->renderEnd ();
   }
 
@@ -319,11 +553,24 @@ struct Mesh::Impl
     this->vertices.reset ();
     this->indices.reset ();
     this->normals.reset ();
+    this->cornerVertices.reset ();
+    this->cornerNormals.reset ();
+    this->cornerBarycentrics.reset ();
+    this->cornersAreDirty = true;
+    this->resetBounds ();
   }
 
-  void scale (const glm::vec3& v) { this->scalingMatrix = glm::scale (this->scalingMatrix, v); }
+  void scale (const glm::vec3& v)
+  {
+    this->scalingMatrix = glm::scale (this->scalingMatrix, v);
+    this->hasWorldBounds = false;
+  }
 
-  void scaling (const glm::vec3& v) { this->scalingMatrix = glm::scale (glm::mat4x4 (1.0f), v); }
+  void scaling (const glm::vec3& v)
+  {
+    this->scalingMatrix = glm::scale (glm::mat4x4 (1.0f), v);
+    this->hasWorldBounds = false;
+  }
 
   glm::vec3 scaling () const
   {
@@ -334,11 +581,13 @@ struct Mesh::Impl
   void translate (const glm::vec3& v)
   {
     this->translationMatrix = glm::translate (this->translationMatrix, v);
+    this->hasWorldBounds = false;
   }
 
   void position (const glm::vec3& v)
   {
     this->translationMatrix = glm::translate (glm::mat4x4 (1.0f), v);
+    this->hasWorldBounds = false;
   }
 
   glm::vec3 position () const
@@ -350,6 +599,7 @@ struct Mesh::Impl
   void rotation (const glm::vec3& axis, float angle)
   {
     this->rotationMatrix = glm::rotate (glm::mat4x4 (1.0f), angle, axis);
+    this->hasWorldBounds = false;
   }
 
   void rotationX (float angle) { this->rotation (glm::vec3 (1.0f, 0.0f, 0.0f), angle); }
@@ -358,11 +608,16 @@ struct Mesh::Impl
 
   void rotationZ (float angle) { this->rotation (glm::vec3 (0.0f, 0.0f, 1.0f), angle); }
 
-  void rotate (const glm::mat4x4& matrix) { this->rotationMatrix = matrix * this->rotationMatrix; }
+  void rotate (const glm::mat4x4& matrix)
+  {
+    this->rotationMatrix = matrix * this->rotationMatrix;
+    this->hasWorldBounds = false;
+  }
 
   void rotate (const glm::vec3& axis, float angle)
   {
     this->rotationMatrix = glm::rotate (this->rotationMatrix, angle, axis);
+    this->hasWorldBounds = false;
   }
 
   void rotateX (float angle) { this->rotate (glm::vec3 (1.0f, 0.0f, 0.0f), angle); }
@@ -387,19 +642,83 @@ struct Mesh::Impl
     this->position (glm::vec3 (0.0f));
     this->scaling (glm::vec3 (1.0f));
     this->rotationMatrix = glm::mat4x4 (1.0f);
+    this->hasWorldBounds = false;
+  }
+
+  void resetBounds () const
+  {
+    this->hasBounds = false;
+    this->hasWorldBounds = false;
+  }
+
+  void extendBounds (const glm::vec3& v) const
+  {
+    assert (this->hasBounds);
+
+    if (glm::any (glm::lessThan (v, this->minimum)) ||
+        glm::any (glm::greaterThan (v, this->maximum)))
+    {
+      this->minimum = glm::min (this->minimum, v);
+      this->maximum = glm::max (this->maximum, v);
+      this->hasWorldBounds = false;
+    }
+  }
+
+  void updateBounds () const
+  {
+    if (this->hasBounds == false)
+    {
+      this->minimum = glm::vec3 (Util::maxFloat ());
+      this->maximum = glm::vec3 (Util::minFloat ());
+
+      for (unsigned int i = 0; i < this->numVertices (); i++)
+      {
+        this->minimum = glm::min (this->minimum, this->vertices.get (i));
+        this->maximum = glm::max (this->maximum, this->vertices.get (i));
+      }
+      this->hasBounds = true;
+      this->hasWorldBounds = false;
+    }
   }
 
   PrimAABox bounds () const
   {
-    glm::vec3 min = glm::vec3 (Util::maxFloat ());
-    glm::vec3 max = glm::vec3 (Util::minFloat ());
+    this->updateBounds ();
+    return PrimAABox (this->minimum, this->maximum);
+  }
 
-    for (unsigned int i = 0; i < this->numVertices (); i++)
+  PrimAABox worldBounds () const
+  {
+    this->updateBounds ();
+
+    if (this->hasWorldBounds == false)
     {
-      min = glm::min (min, this->vertices.get (i));
-      max = glm::max (max, this->vertices.get (i));
+      if (this->numVertices () == 0)
+      {
+        this->worldMinimum = this->minimum;
+        this->worldMaximum = this->maximum;
+      }
+      else
+      {
+        const glm::mat4x4 model = this->modelMatrix ();
+        const glm::vec3   center =
+          Util::transformPosition (model, (this->minimum + this->maximum) * 0.5f);
+        const glm::vec3   halfWidth = (this->maximum - this->minimum) * 0.5f;
+        glm::vec3         extent (0.0f);
+
+        for (unsigned int i = 0; i < 3; i++)
+        {
+          for (unsigned int j = 0; j < 3; j++)
+          {
+            extent[i] += glm::abs (model[j][i]) * halfWidth[j];
+          }
+        }
+        this->worldMinimum = center - extent;
+        this->worldMaximum = center + extent;
+      }
+      this->hasWorldBounds = true;
     }
-    return PrimAABox (min, max);
+    return PrimAABox (this->worldMinimum, this->worldMaximum);
   }
 };
 
@@ -423,11 +742,13 @@ DELEGATE2 (void, Mesh, vertex, unsigned int, const glm::vec3&)
 DELEGATE2 (void, Mesh, normal, unsigned int, const glm::vec3&)
 
 DELEGATE (void, Mesh, bufferData)
+DELEGATE (void, Mesh, bufferVertexData)
 DELEGATE_CONST (glm::mat4x4, Mesh, modelMatrix)
 DELEGATE_CONST (glm::mat3x3, Mesh, modelNormalMatrix)
 DELEGATE1_CONST (void, Mesh, renderBegin, Camera&)
 DELEGATE_CONST (void, Mesh, renderEnd)
 DELEGATE1_CONST (void, Mesh, render, Camera&)
+DELEGATE2_CONST (void, Mesh, render, Camera&, const std::function<void()>&)
 DELEGATE1_CONST (void, Mesh, renderLines, Camera&)
 DELEGATE (void, Mesh, reset)
 DELEGATE (void, Mesh, resetGeometry)
@@ -440,7 +761,6 @@ DELEGATE_CONST (glm::vec3, Mesh, scaling)
 DELEGATE1 (void, Mesh, translate, const glm::vec3&)
 DELEGATE1 (void, Mesh, position, const glm::vec3&)
 DELEGATE_CONST (glm::vec3, Mesh, position)
-SETTER (const glm::mat4x4&, Mesh, rotationMatrix)
 GETTER_CONST (const glm::mat4x4&, Mesh, rotationMatrix)
 DELEGATE2 (void, Mesh, rotation, const glm::vec3&, float)
 DELEGATE1 (void, Mesh, rotationX, float)
@@ -453,7 +773,14 @@ DELEGATE1 (void, Mesh, rotateY, float)
 DELEGATE1 (void, Mesh, rotateZ, float)
 DELEGATE (void, Mesh, normalize)
 DELEGATE_CONST (PrimAABox, Mesh, bounds)
+DELEGATE_CONST (PrimAABox, Mesh, worldBounds)
 GETTER_CONST (const Color&, Mesh, color)
 SETTER (const Color&, Mesh, color)
 GETTER_CONST (const Color&, Mesh, wireframeColor)
 SETTER (const Color&, Mesh, wireframeColor)
+
+void Mesh::rotationMatrix (const glm::mat4x4& matrix)
+{
+  this->impl->rotationMatrix = matrix;
+  this->impl->hasWorldBounds = false;
+}
@@ -5,6 +5,7 @@
 #ifndef DILAY_MESH
 #define DILAY_MESH
 
+#include <functional>
 #include <glm/fwd.hpp>
 #include "macro.hpp"
 
@@ -37,11 +38,13 @@ public:
   void             normal (unsigned int, const glm::vec3&);
 
   void              bufferData ();
+  void              bufferVertexData ();
   glm::mat4x4       modelMatrix () const;
   glm::mat3x3       modelNormalMatrix () const;
   void              renderBegin (Camera&) const;
   void              renderEnd () const;
   void              render (Camera&) const;
+  void              render (Camera&, const std::function<void()>&) const;
   void              renderLines (Camera&) const;
   void              reset ();
   void              resetGeometry ();
@@ -67,6 +70,7 @@ public:
   void               rotateZ (float);
   void               normalize ();
   PrimAABox          bounds () const;
+  PrimAABox          worldBounds () const;
   const Color&       color () const;
   void               color (const Color&);
   const Color&       wireframeColor () const;
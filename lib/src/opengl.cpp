@@ -32,6 +32,11 @@
   {                                                     \
     return fun->method (a1, a2, a3, a4, a5, a6);        \
   }
+#define DELEGATE7_GL(r, method, t1, t2, t3, t4, t5, t6, t7)   \
+  r method (t1 a1, t2 a2, t3 a3, t4 a4, t5 a5, t6 a6, t7 a7) \
+  {                                                          \
+    return fun->method (a1, a2, a3, a4, a5, a6, a7);         \
+  }
 
 namespace OpenGL
 {
@@ -98,6 +103,7 @@ namespace OpenGL
   DELEGATE_GL_CONSTANT (Decr, GL_DECR);
   DELEGATE_GL_CONSTANT (DecrWrap, GL_DECR_WRAP);
   DELEGATE_GL_CONSTANT (DepthBufferBit, GL_DEPTH_BUFFER_BIT);
+  DELEGATE_GL_CONSTANT (DepthComponent, GL_DEPTH_COMPONENT);
   DELEGATE_GL_CONSTANT (DepthTest, GL_DEPTH_TEST);
   DELEGATE_GL_CONSTANT (DstColor, GL_DST_COLOR);
   DELEGATE_GL_CONSTANT (ElementArrayBuffer, GL_ELEMENT_ARRAY_BUFFER);
@@ -118,10 +124,12 @@ namespace OpenGL
   DELEGATE_GL_CONSTANT (Never, GL_NEVER);
   DELEGATE_GL_CONSTANT (PolygonOffsetFill, GL_POLYGON_OFFSET_FILL);
   DELEGATE_GL_CONSTANT (Replace, GL_REPLACE);
+  DELEGATE_GL_CONSTANT (RGBA, GL_RGBA);
   DELEGATE_GL_CONSTANT (StaticDraw, GL_STATIC_DRAW);
   DELEGATE_GL_CONSTANT (StencilBufferBit, GL_STENCIL_BUFFER_BIT);
   DELEGATE_GL_CONSTANT (StencilTest, GL_STENCIL_TEST);
   DELEGATE_GL_CONSTANT (Triangles, GL_TRIANGLES);
+  DELEGATE_GL_CONSTANT (UnsignedByte, GL_UNSIGNED_BYTE);
   DELEGATE_GL_CONSTANT (UnsignedInt, GL_UNSIGNED_INT);
   DELEGATE_GL_CONSTANT (Zero, GL_ZERO);
 
@@ -139,6 +147,7 @@ namespace OpenGL
   DELEGATE1_GL (void, glDepthMask, bool)
   DELEGATE1_GL (void, glDisable, unsigned int)
   DELEGATE1_GL (void, glDisableVertexAttribArray, unsigned int)
+  DELEGATE3_GL (void, glDrawArrays, unsigned int, int, unsigned int)
   DELEGATE4_GL (void, glDrawElements, unsigned int, unsigned int, unsigned int, const void*)
   DELEGATE1_GL (void, glEnable, unsigned int)
   DELEGATE1_GL (void, glEnableVertexAttribArray, unsigned int)
@@ -150,6 +159,8 @@ namespace OpenGL
   DELEGATE1_GL (bool, glIsProgram, unsigned int)
   DELEGATE2_GL (void, glPolygonMode, unsigned int, unsigned int)
   DELEGATE2_GL (void, glPolygonOffset, float, float)
+  DELEGATE7_GL (void, glReadPixels, int, int, unsigned int, unsigned int, unsigned int,
+                unsigned int, void*)
   DELEGATE3_GL (void, glStencilFunc, unsigned int, int, unsigned int)
   DELEGATE3_GL (void, glStencilOp, unsigned int, unsigned int, unsigned int)
   DELEGATE2_GL (void, glUniform1f, int, float)
@@ -255,6 +266,7 @@ namespace OpenGL
 
     fun->glBindAttribLocation (programId, OpenGL::PositionIndex, "position");
     fun->glBindAttribLocation (programId, OpenGL::NormalIndex, "normal");
+    fun->glBindAttribLocation (programId, OpenGL::BarycentricIndex, "vertexBarycentric");
 
     fun->glLinkProgram (programId);
 
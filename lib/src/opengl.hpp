@@ -27,6 +27,7 @@ namespace OpenGL
   unsigned int Decr ();
   unsigned int DecrWrap ();
   unsigned int DepthBufferBit ();
+  unsigned int DepthComponent ();
   unsigned int DepthTest ();
   unsigned int DstColor ();
   unsigned int ElementArrayBuffer ();
@@ -47,10 +48,12 @@ namespace OpenGL
   unsigned int Never ();
   unsigned int PolygonOffsetFill ();
   unsigned int Replace ();
+  unsigned int RGBA ();
   unsigned int StaticDraw ();
   unsigned int StencilBufferBit ();
   unsigned int StencilTest ();
   unsigned int Triangles ();
+  unsigned int UnsignedByte ();
   unsigned int UnsignedInt ();
   unsigned int Zero ();
 
@@ -68,6 +71,7 @@ namespace OpenGL
   void glDepthMask (bool);
   void glDisable (unsigned int);
   void glDisableVertexAttribArray (unsigned int);
+  void glDrawArrays (unsigned int, int, unsigned int);
   void glDrawElements (unsigned int, unsigned int, unsigned int, const void*);
   void glEnable (unsigned int);
   void glEnableVertexAttribArray (unsigned int);
@@ -79,6 +83,7 @@ namespace OpenGL
   bool glIsProgram (unsigned int);
   void glPolygonMode (unsigned int, unsigned int);
   void glPolygonOffset (float, float);
+  void glReadPixels (int, int, unsigned int, unsigned int, unsigned int, unsigned int, void*);
   void glStencilFunc (unsigned int, int, unsigned int);
   void glStencilOp (unsigned int, unsigned int, unsigned int);
   void glUniform1f (int, float);
@@ -92,7 +97,8 @@ namespace OpenGL
   enum VertexAttributIndex
   {
     PositionIndex = 0,
-    NormalIndex = 1
+    NormalIndex = 1,
+    BarycentricIndex = 2
   };
 
   bool         hasGeometryShader ();
@@ -0,0 +1,34 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include "primitive/frustum.hpp"
+
+// cf. Gribb & Hartmann: Fast Extraction of Viewing Frustum Planes from the World-View-Projection
+// Matrix
+PrimFrustum::PrimFrustum (const glm::mat4x4& m)
+{
+  const glm::vec4 row0 (m[0][0], m[1][0], m[2][0], m[3][0]);
+  const glm::vec4 row1 (m[0][1], m[1][1], m[2][1], m[3][1]);
+  const glm::vec4 row2 (m[0][2], m[1][2], m[2][2], m[3][2]);
+  const glm::vec4 row3 (m[0][3], m[1][3], m[2][3], m[3][3]);
+
+  this->_planes[0] = row3 + row0;
+  this->_planes[1] = row3 - row0;
+  this->_planes[2] = row3 + row1;
+  this->_planes[3] = row3 - row1;
+  this->_planes[4] = row3 + row2;
+  this->_planes[5] = row3 - row2;
+}
+
+PrimFrustum PrimFrustum::transform (const glm::mat4x4& model) const
+{
+  const glm::mat4x4 transposed = glm::transpose (model);
+
+  PrimFrustum frustum;
+  for (unsigned int i = 0; i < 6; i++)
+  {
+    frustum._planes[i] = transposed * this->_planes[i];
+  }
+  return frustum;
+}
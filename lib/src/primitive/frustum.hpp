@@ -0,0 +1,28 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_PRIMITIVE_FRUSTUM
+#define DILAY_PRIMITIVE_FRUSTUM
+
+#include <array>
+#include <glm/glm.hpp>
+
+class PrimFrustum
+{
+public:
+  PrimFrustum (const glm::mat4x4&);
+
+  // each plane `(n, d)` satisfies `dot (n, p) + d >= 0` for points `p` inside the frustum
+  const std::array<glm::vec4, 6>& planes () const { return this->_planes; }
+
+  // transforms the frustum into the local space of a model matrix
+  PrimFrustum transform (const glm::mat4x4&) const;
+
+private:
+  PrimFrustum () = default;
+
+  std::array<glm::vec4, 6> _planes;
+};
+
+#endif
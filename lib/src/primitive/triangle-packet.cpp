@@ -0,0 +1,43 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include "primitive/triangle-packet.hpp"
+
+constexpr unsigned int PrimTrianglePacket::maxSize;
+
+PrimTrianglePacket::PrimTrianglePacket ()
+  : _size (0)
+{
+  this->reset ();
+}
+
+void PrimTrianglePacket::add (const glm::vec3& v1, const glm::vec3& v2, const glm::vec3& v3)
+{
+  assert (this->isFull () == false);
+
+  const unsigned int lane = this->_size;
+
+  for (unsigned int d = 0; d < 3; d++)
+  {
+    this->_coordinates[0][d][lane] = v1[d];
+    this->_coordinates[1][d][lane] = v2[d];
+    this->_coordinates[2][d][lane] = v3[d];
+  }
+  this->_size++;
+}
+
+void PrimTrianglePacket::reset ()
+{
+  for (unsigned int v = 0; v < 3; v++)
+  {
+    for (unsigned int d = 0; d < 3; d++)
+    {
+      for (unsigned int lane = 0; lane < maxSize; lane++)
+      {
+        this->_coordinates[v][d][lane] = 0.0f;
+      }
+    }
+  }
+  this->_size = 0;
+}
@@ -0,0 +1,40 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_PRIMITIVE_TRIANGLE_PACKET
+#define DILAY_PRIMITIVE_TRIANGLE_PACKET
+
+#include <glm/glm.hpp>
+
+/* Up to `maxSize` triangles stored as structure of arrays, i.e. one array of lanes per vertex and
+ * dimension. Intersection tests process all lanes by the same branch-free loop, which compilers
+ * vectorize. Unused lanes are zeroed.
+ */
+class PrimTrianglePacket
+{
+public:
+  static constexpr unsigned int maxSize = 8;
+
+  PrimTrianglePacket ();
+
+  unsigned int size () const { return this->_size; }
+  bool         isEmpty () const { return this->_size == 0; }
+  bool         isFull () const { return this->_size == maxSize; }
+  unsigned int mask () const { return (1u << this->_size) - 1u; }
+
+  glm::vec3 vertex (unsigned int v, unsigned int lane) const
+  {
+    return glm::vec3 (this->_coordinates[v][0][lane], this->_coordinates[v][1][lane],
+                      this->_coordinates[v][2][lane]);
+  }
+
+  void add (const glm::vec3&, const glm::vec3&, const glm::vec3&);
+  void reset ();
+
+private:
+  float        _coordinates[3][3][maxSize];
+  unsigned int _size;
+};
+
+#endif
@@ -3,6 +3,7 @@
  * Use and redistribute under the terms of the GNU General Public License
  */
 #include <cstdlib>
+#include "opengl.hpp"
 #include "render-mode.hpp"
 #include "shader.hpp"
 #include "util.hpp"
@@ -32,19 +33,27 @@ bool RenderMode::cameraRotationOnly () const { return this->flags.get<4> (); }
 
 bool RenderMode::noDepthTest () const { return this->flags.get<5> (); }
 
+bool RenderMode::renderBarycentricWireframe () const
+{
+  return this->renderWireframe () && OpenGL::hasGeometryShader () == false;
+}
+
 const char* RenderMode::vertexShader () const
 {
   if (this->smoothShading ())
   {
-    return Shader::smoothVertexShader ();
+    return this->renderBarycentricWireframe () ? Shader::smoothBarycentricVertexShader ()
+                                               : Shader::smoothVertexShader ();
   }
   else if (this->flatShading ())
   {
-    return Shader::flatVertexShader ();
+    return this->renderBarycentricWireframe () ? Shader::flatBarycentricVertexShader ()
+                                               : Shader::flatVertexShader ();
   }
   else if (this->constantShading ())
   {
-    return Shader::constantVertexShader ();
+    return this->renderBarycentricWireframe () ? Shader::constantBarycentricVertexShader ()
+                                               : Shader::constantVertexShader ();
   }
   else
   {
@@ -56,11 +65,19 @@ const char* RenderMode::fragmentShader () const
 {
   if (this->smoothShading ())
   {
+    if (this->renderBarycentricWireframe ())
+    {
+      return Shader::smoothBarycentricFragmentShader ();
+    }
     return this->renderWireframe () ? Shader::smoothWireframeFragmentShader ()
                                     : Shader::smoothFragmentShader ();
   }
   else if (this->flatShading ())
   {
+    if (this->renderBarycentricWireframe ())
+    {
+      return Shader::flatBarycentricFragmentShader ();
+    }
     return this->renderWireframe () ? Shader::flatWireframeFragmentShader ()
                                     : Shader::flatFragmentShader ();
   }
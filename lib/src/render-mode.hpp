@@ -19,6 +19,7 @@ public:
   bool        renderWireframe () const;
   bool        cameraRotationOnly () const;
   bool        noDepthTest () const;
+  bool        renderBarycentricWireframe () const;
   const char* vertexShader () const;
   const char* fragmentShader () const;
 
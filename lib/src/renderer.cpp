@@ -38,7 +38,6 @@ namespace
     int          colorId;
     int          wireframeColorId;
     int          eyePointId;
-    int          barycentricId;
     LightIds     lightIds[numLights];
 
     ShaderIds ()
@@ -50,7 +49,6 @@ namespace
       , colorId (0)
       , wireframeColorId (0)
       , eyePointId (0)
-      , barycentricId (0)
     {
     }
   };
@@ -133,10 +131,10 @@ struct Renderer::Impl
 
   void initalizeProgram (const RenderMode& renderMode)
   {
-    assert (renderMode.renderWireframe () == false || OpenGL::hasGeometryShader ());
-
+    const bool         useGeometryShader =
+      renderMode.renderWireframe () && renderMode.renderBarycentricWireframe () == false;
     const unsigned int id = OpenGL::loadProgram (
-      renderMode.vertexShader (), renderMode.fragmentShader (), renderMode.renderWireframe ());
+      renderMode.vertexShader (), renderMode.fragmentShader (), useGeometryShader);
 
     unsigned int index = this->shaderIndex (renderMode);
     assert (this->shaderIds[index].programId == 0);
@@ -151,7 +149,6 @@ struct Renderer::Impl
     s->colorId = OpenGL::glGetUniformLocation (id, "color");
     s->wireframeColorId = OpenGL::glGetUniformLocation (id, "wireframeColor");
     s->eyePointId = OpenGL::glGetUniformLocation (id, "eyePoint");
-    s->barycentricId = OpenGL::glGetUniformLocation (id, "barycentric");
     s->lightIds[0].directionId = OpenGL::glGetUniformLocation (id, "light1Direction");
     s->lightIds[0].colorId = OpenGL::glGetUniformLocation (id, "light1Color");
     s->lightIds[0].irradianceId = OpenGL::glGetUniformLocation (id, "light1Irradiance");
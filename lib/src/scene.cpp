@@ -2,12 +2,20 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 #include <list>
+#include <vector>
+#include "bvh.hpp"
+#include "camera.hpp"
 #include "config.hpp"
 #include "dynamic/mesh-intersection.hpp"
 #include "dynamic/mesh.hpp"
 #include "import-export.hpp"
 #include "intersection.hpp"
+#include "mesh.hpp"
+#include "primitive/aabox.hpp"
+#include "primitive/frustum.hpp"
 #include "render-mode.hpp"
 #include "scene.hpp"
 #include "sketch/bone-intersection.hpp"
@@ -17,16 +25,113 @@
 #include "sketch/path-intersection.hpp"
 #include "util.hpp"
 
+namespace
+{
+  // bounds in the space the mesh is intersected in
+  void getBounds (const DynamicMesh& mesh, glm::vec3& min, glm::vec3& max)
+  {
+    const PrimAABox bounds = mesh.mesh ().bounds ();
+
+    min = bounds.minimum ();
+    max = bounds.maximum ();
+  }
+
+  void getBounds (const SketchMesh& mesh, glm::vec3& min, glm::vec3& max)
+  {
+    mesh.minMax (min, max);
+  }
+
+  /* BVH of the meshes of a list.
+   * Meshes may be edited or transformed between queries without notifying the scene. Their bounds
+   * are cached by the meshes themselves, so they are compared before each query and the BVH is only
+   * refitted if some bounds changed. It is rebuilt after meshes were added or deleted.
+   */
+  template <typename T> struct MeshBVH
+  {
+    std::list<T>&          list;
+    std::vector<T*>        meshes;
+    std::vector<glm::vec3> minima;
+    std::vector<glm::vec3> maxima;
+    BVH                    bvh;
+    bool                   isDirty;
+
+    MeshBVH (std::list<T>& l)
+      : list (l)
+      , isDirty (true)
+    {
+    }
+
+    void update ()
+    {
+      const auto bounds = [this](unsigned int i, glm::vec3& min, glm::vec3& max) {
+        min = this->minima[i];
+        max = this->maxima[i];
+      };
+
+      if (this->isDirty)
+      {
+        this->meshes.clear ();
+        for (T& mesh : this->list)
+        {
+          this->meshes.push_back (&mesh);
+        }
+        this->minima.resize (this->meshes.size ());
+        this->maxima.resize (this->meshes.size ());
+
+        for (unsigned int i = 0; i < this->meshes.size (); i++)
+        {
+          getBounds (*this->meshes[i], this->minima[i], this->maxima[i]);
+        }
+        this->bvh.build (this->meshes.size (), bounds);
+        this->isDirty = false;
+      }
+      else
+      {
+        bool changed = false;
+        for (unsigned int i = 0; i < this->meshes.size (); i++)
+        {
+          glm::vec3 min, max;
+          getBounds (*this->meshes[i], min, max);
+
+          if (min != this->minima[i] || max != this->maxima[i])
+          {
+            this->minima[i] = min;
+            this->maxima[i] = max;
+            changed = true;
+          }
+        }
+        if (changed)
+        {
+          this->bvh.refit (bounds);
+        }
+      }
+    }
+
+    void intersects (const PrimRay& ray, float maxDistance, const std::function<float(T&)>& f)
+    {
+      this->update ();
+      this->bvh.intersects (ray, maxDistance,
+                            [this, &f](unsigned int i) { return f (*this->meshes[i]); });
+    }
+  };
+}
+
 struct Scene::Impl
 {
   Scene*                 self;
   std::list<DynamicMesh> dynamicMeshes;
   std::list<SketchMesh>  sketchMeshes;
+  MeshBVH<DynamicMesh>   dynamicMeshBVH;
+  MeshBVH<SketchMesh>    sketchMeshBVH;
   RenderMode             commonRenderMode;
   std::string            fileName;
+  bool                   navigating;
 
   Impl (Scene* s, const Config& config)
     : self (s)
+    , dynamicMeshBVH (this->dynamicMeshes)
+    , sketchMeshBVH (this->sketchMeshes)
+    , navigating (false)
   {
     this->runFromConfig (config);
 
@@ -36,6 +141,7 @@ struct Scene::Impl
   DynamicMesh& newDynamicMesh (const Config& config, const DynamicMesh& other)
   {
     this->dynamicMeshes.emplace_back (other);
+    this->dynamicMeshBVH.isDirty = true;
     this->setupMesh (config, this->dynamicMeshes.back ());
     return this->dynamicMeshes.back ();
   }
@@ -43,6 +149,7 @@ struct Scene::Impl
   DynamicMesh& newDynamicMesh (const Config& config, const Mesh& mesh)
   {
     this->dynamicMeshes.emplace_back (mesh);
+    this->dynamicMeshBVH.isDirty = true;
     this->setupMesh (config, this->dynamicMeshes.back ());
     return this->dynamicMeshes.back ();
   }
@@ -50,6 +157,7 @@ struct Scene::Impl
   SketchMesh& newSketchMesh (const Config& config, const SketchMesh& other)
   {
     this->sketchMeshes.emplace_back (other);
+    this->sketchMeshBVH.isDirty = true;
     this->setupMesh (config, this->sketchMeshes.back ());
     return this->sketchMeshes.back ();
   }
@@ -58,6 +166,7 @@ struct Scene::Impl
   {
     this->sketchMeshes.emplace_back ();
     this->sketchMeshes.back ().fromTree (tree);
+    this->sketchMeshBVH.isDirty = true;
     this->setupMesh (config, this->sketchMeshes.back ());
     return this->sketchMeshes.back ();
   }
@@ -82,6 +191,7 @@ struct Scene::Impl
       if (&*it == &mesh)
       {
         this->dynamicMeshes.erase (it);
+        this->dynamicMeshBVH.isDirty = true;
         this->resetIfEmpty ();
         return;
       }
@@ -96,6 +206,7 @@ struct Scene::Impl
       if (&*it == &mesh)
       {
         this->sketchMeshes.erase (it);
+        this->sketchMeshBVH.isDirty = true;
         this->resetIfEmpty ();
         return;
       }
@@ -103,62 +214,108 @@ struct Scene::Impl
     DILAY_IMPOSSIBLE
   }
 
-  void deleteDynamicMeshes () { this->dynamicMeshes.clear (); }
+  void deleteDynamicMeshes ()
+  {
+    this->dynamicMeshes.clear ();
+    this->dynamicMeshBVH.isDirty = true;
+  }
 
-  void deleteSketchMeshes () { this->sketchMeshes.clear (); }
+  void deleteSketchMeshes ()
+  {
+    this->sketchMeshes.clear ();
+    this->sketchMeshBVH.isDirty = true;
+  }
 
   void deleteEmptyMeshes ()
   {
     this->dynamicMeshes.remove_if ([](const auto& mesh) { return mesh.isEmpty (); });
     this->sketchMeshes.remove_if ([](const auto& mesh) { return mesh.isEmpty (); });
+    this->dynamicMeshBVH.isDirty = true;
+    this->sketchMeshBVH.isDirty = true;
     this->resetIfEmpty ();
   }
 
   void render (Camera& camera)
   {
-    this->forEachMesh ([&](DynamicMesh& m) { m.render (camera); });
-    this->forEachMesh ([&](SketchMesh& m) { m.render (camera); });
+    const PrimFrustum frustum (camera.viewProjection ());
+
+    this->forEachMesh ([this, &camera, &frustum](DynamicMesh& m) {
+      if (m.intersects (frustum))
+      {
+        if (this->navigating == false || this->renderProxy (camera, m) == false)
+        {
+          m.render (camera);
+        }
+      }
+    });
+    this->forEachMesh ([&camera, &frustum](SketchMesh& m) {
+      glm::vec3 min, max;
+      m.minMax (min, max);
+
+      if (m.isEmpty () == false && IntersectionUtil::intersects (frustum, PrimAABox (min, max)))
+      {
+        m.render (camera);
+      }
+    });
+  }
+
+  bool renderProxy (Camera& camera, DynamicMesh& mesh)
+  {
+    // roughly the number of pixels a face should cover on screen
+    constexpr float numPixelsPerFace = 4.0f;
+
+    const PrimAABox bounds = mesh.mesh ().worldBounds ();
+    const float     distance = glm::distance (bounds.center (), camera.position ());
+    const float     radius = camera.fromWorld (glm::length (bounds.halfWidth ()), distance);
+    const float     numPixels = glm::pi<float> () * radius * radius;
+    const float     numFaces = glm::min (numPixels / numPixelsPerFace, float(mesh.numFaces ()));
+
+    mesh.updateProxies ();
+    return mesh.renderProxy (camera, (unsigned int) (numFaces));
   }
 
   template <typename TMesh, typename TIntersection, typename... Ts>
-  bool intersectsT (const PrimRay& ray, TIntersection& intersection, Ts... args)
+  bool intersectsT (MeshBVH<TMesh>& meshBVH, float maxDistance, const PrimRay& ray,
+                    TIntersection& intersection, Ts... args)
   {
-    this->forEachMesh ([&ray, &intersection, &args...](TMesh& m) {
+    meshBVH.intersects (ray, maxDistance, [&ray, &intersection, &args...](TMesh& m) {
       m.intersects (ray, intersection, std::forward<Ts> (args)...);
+      return intersection.isIntersection () ? intersection.distance () : Util::maxFloat ();
     });
     return intersection.isIntersection ();
   }
 
   bool intersects (const PrimRay& ray, DynamicMeshIntersection& intersection)
   {
-    return this->intersectsT<DynamicMesh> (ray, intersection);
+    return this->intersectsT (this->dynamicMeshBVH, Util::maxFloat (), ray, intersection);
   }
 
   bool intersects (const PrimRay& ray, SketchNodeIntersection& intersection,
                    const SketchNode* exclude)
   {
-    return this->intersectsT<SketchMesh> (ray, intersection, exclude);
+    return this->intersectsT (this->sketchMeshBVH, Util::maxFloat (), ray, intersection, exclude);
   }
 
   bool intersects (const PrimRay& ray, SketchBoneIntersection& intersection)
   {
-    return this->intersectsT<SketchMesh> (ray, intersection);
+    return this->intersectsT (this->sketchMeshBVH, Util::maxFloat (), ray, intersection);
   }
 
   bool intersects (const PrimRay& ray, SketchMeshIntersection& intersection)
   {
-    return this->intersectsT<SketchMesh> (ray, intersection);
+    return this->intersectsT (this->sketchMeshBVH, Util::maxFloat (), ray, intersection);
   }
 
   bool intersects (const PrimRay& ray, SketchMeshIntersection& intersection,
                    unsigned int numExcludedLastPaths)
   {
-    return this->intersectsT<SketchMesh> (ray, intersection, numExcludedLastPaths);
+    return this->intersectsT (this->sketchMeshBVH, Util::maxFloat (), ray, intersection,
+                              numExcludedLastPaths);
   }
 
   bool intersects (const PrimRay& ray, SketchPathIntersection& intersection)
   {
-    return this->intersectsT<SketchMesh> (ray, intersection);
+    return this->intersectsT (this->sketchMeshBVH, Util::maxFloat (), ray, intersection);
   }
 
   bool intersects (const PrimRay& ray, Intersection& intersection)
@@ -171,7 +328,11 @@ struct Scene::Impl
       intersection.update (dIntersection.distance (), dIntersection.position (),
                            dIntersection.normal ());
     }
-    if (this->intersects (ray, sIntersection))
+    // sketch meshes behind the nearest dynamic mesh are skipped
+    const float maxDistance =
+      intersection.isIntersection () ? intersection.distance () : Util::maxFloat ();
+
+    if (this->intersectsT (this->sketchMeshBVH, maxDistance, ray, sIntersection))
     {
       intersection.update (sIntersection.distance (), sIntersection.position (),
                            sIntersection.normal ());
@@ -393,6 +554,8 @@ DELEGATE_CONST (unsigned int, Scene, numSketchMeshes)
 DELEGATE_CONST (unsigned int, Scene, numFaces)
 DELEGATE_CONST (bool, Scene, hasFileName)
 GETTER_CONST (const std::string&, Scene, fileName)
+GETTER_CONST (bool, Scene, navigating)
+SETTER (bool, Scene, navigating)
 DELEGATE1 (bool, Scene, toDlyFile, bool)
 DELEGATE2 (bool, Scene, toDlyFile, const std::string&, bool)
 DELEGATE2 (bool, Scene, fromDlyFile, const Config&, const std::string&)
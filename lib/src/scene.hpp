@@ -60,6 +60,8 @@ public:
   unsigned int       numFaces () const;
   bool               hasFileName () const;
   const std::string& fileName () const;
+  bool               navigating () const;
+  void               navigating (bool);
   bool               toDlyFile (bool);
   bool               toDlyFile (const std::string&, bool);
   bool               fromDlyFile (const Config&, const std::string&);
@@ -4,7 +4,7 @@
  */
 #include "shader.hpp"
 
-#define SMOOTH_VERTEX_SHADER                                                                   \
+#define SMOOTH_VERTEX_SHADER(DECLARATION, ASSIGNMENT)                                          \
   "#version 120                                                                            \n" \
   "                                                                                        \n" \
   "uniform   mat4  model;                                                                  \n" \
@@ -22,6 +22,7 @@
   "uniform   float light2Irradiance;                                                       \n" \
   "                                                                                        \n" \
   "varying vec3 vsColor;                                                                   \n" \
+  DECLARATION                                                                                  \
   "                                                                                        \n" \
   "void main () {                                                                          \n" \
   "  gl_Position      = (projection * view * model) * vec4 (position, 1.0);                \n" \
@@ -31,6 +32,7 @@
   "  vec3  light1     = light1Irradiance * light1Color * light1Diff;                       \n" \
   "  vec3  light2     = light2Irradiance * light2Color * light2Diff;                       \n" \
   "        vsColor    = color * (light1 + light2);                                         \n" \
+  ASSIGNMENT                                                                                   \
   "}                                                                                       \n"
 
 #define SMOOTH_FRAGMENT_SHADER(COLOR, FINAL)                                                   \
@@ -46,7 +48,7 @@
   ", 1.0);                                                 \n" FINAL                           \
   "}                                                                                       \n"
 
-#define FLAT_VERTEX_SHADER                                                                     \
+#define FLAT_VERTEX_SHADER(DECLARATION, ASSIGNMENT)                                            \
   "#version 120                                                                            \n" \
   "                                                                                        \n" \
   "uniform   mat4 model;                                                                   \n" \
@@ -55,10 +57,12 @@
   "attribute vec3 position;                                                                \n" \
   "                                                                                        \n" \
   "varying vec3 vsColor;                                                                   \n" \
+  DECLARATION                                                                                  \
   "                                                                                        \n" \
   "void main () {                                                                          \n" \
   "  gl_Position = (projection * view * model) * vec4 (position,1.0);                      \n" \
   "  vsColor     = vec3 (model * vec4 (position, 1.0));                                    \n" \
+  ASSIGNMENT                                                                                   \
   "}                                                                                       \n"
 
 #define FLAT_FRAGMENT_SHADER(COLOR, FINAL)                                                     \
@@ -90,16 +94,18 @@
   "\n" FINAL                                                                                   \
   "}                                                                                       \n"
 
-#define CONSTANT_VERTEX_SHADER                                                                 \
+#define CONSTANT_VERTEX_SHADER(DECLARATION, ASSIGNMENT)                                        \
   "#version 120                                                                            \n" \
   "                                                                                        \n" \
   "uniform   mat4 model;                                                                   \n" \
   "uniform   mat4 view;                                                                    \n" \
   "uniform   mat4 projection;                                                              \n" \
   "attribute vec3 position;                                                                \n" \
+  DECLARATION                                                                                  \
   "                                                                                        \n" \
   "void main(){                                                                            \n" \
   "  gl_Position = (projection * view * model) * vec4 (position,1.0);                      \n" \
+  ASSIGNMENT                                                                                   \
   "}                                                                                       \n"
 
 #define CONSTANT_FRAGMENT_SHADER(FINAL)                                                        \
@@ -115,6 +121,13 @@
   "\n" FINAL                                                                                   \
   "}                                                                                       \n"
 
+#define BARYCENTRIC_DECLARATION                                                                \
+  "attribute vec3 vertexBarycentric;                                                       \n" \
+  "varying   vec3 barycentric;                                                             \n"
+
+#define BARYCENTRIC_ASSIGNMENT                                                                 \
+  "  barycentric = vertexBarycentric;                                                      \n"
+
 #define ADD_WIREFRAME                                                                          \
   "vec3 barycDelta = fwidth (barycentric);                                                 \n" \
   "                                                                                        \n" \
@@ -149,7 +162,7 @@
   "    EndPrimitive();                                                                     \n" \
   "}                                                                                       \n"
 
-const char* Shader::smoothVertexShader () { return SMOOTH_VERTEX_SHADER; }
+const char* Shader::smoothVertexShader () { return SMOOTH_VERTEX_SHADER ("", ""); }
 
 const char* Shader::smoothFragmentShader () { return SMOOTH_FRAGMENT_SHADER ("vsColor", ""); }
 
@@ -158,7 +171,17 @@ const char* Shader::smoothWireframeFragmentShader ()
   return SMOOTH_FRAGMENT_SHADER ("gsColor", ADD_WIREFRAME);
 }
 
-const char* Shader::flatVertexShader () { return FLAT_VERTEX_SHADER; }
+const char* Shader::smoothBarycentricVertexShader ()
+{
+  return SMOOTH_VERTEX_SHADER (BARYCENTRIC_DECLARATION, BARYCENTRIC_ASSIGNMENT);
+}
+
+const char* Shader::smoothBarycentricFragmentShader ()
+{
+  return SMOOTH_FRAGMENT_SHADER ("vsColor", ADD_WIREFRAME);
+}
+
+const char* Shader::flatVertexShader () { return FLAT_VERTEX_SHADER ("", ""); }
 
 const char* Shader::flatFragmentShader () { return FLAT_FRAGMENT_SHADER ("vsColor", ""); }
 
@@ -167,7 +190,17 @@ const char* Shader::flatWireframeFragmentShader ()
   return FLAT_FRAGMENT_SHADER ("gsColor", ADD_WIREFRAME);
 }
 
-const char* Shader::constantVertexShader () { return CONSTANT_VERTEX_SHADER; }
+const char* Shader::flatBarycentricVertexShader ()
+{
+  return FLAT_VERTEX_SHADER (BARYCENTRIC_DECLARATION, BARYCENTRIC_ASSIGNMENT);
+}
+
+const char* Shader::flatBarycentricFragmentShader ()
+{
+  return FLAT_FRAGMENT_SHADER ("vsColor", ADD_WIREFRAME);
+}
+
+const char* Shader::constantVertexShader () { return CONSTANT_VERTEX_SHADER ("", ""); }
 
 const char* Shader::constantFragmentShader () { return CONSTANT_FRAGMENT_SHADER (""); }
 
@@ -176,4 +209,9 @@ const char* Shader::constantWireframeFragmentShader ()
   return CONSTANT_FRAGMENT_SHADER (ADD_WIREFRAME);
 }
 
+const char* Shader::constantBarycentricVertexShader ()
+{
+  return CONSTANT_VERTEX_SHADER (BARYCENTRIC_DECLARATION, BARYCENTRIC_ASSIGNMENT);
+}
+
 const char* Shader::geometryShader () { return GEOMETRY_SHADER; }
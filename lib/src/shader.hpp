@@ -10,14 +10,19 @@ namespace Shader
   const char* smoothVertexShader ();
   const char* smoothFragmentShader ();
   const char* smoothWireframeFragmentShader ();
+  const char* smoothBarycentricVertexShader ();
+  const char* smoothBarycentricFragmentShader ();
 
   const char* flatVertexShader ();
   const char* flatFragmentShader ();
   const char* flatWireframeFragmentShader ();
+  const char* flatBarycentricVertexShader ();
+  const char* flatBarycentricFragmentShader ();
 
   const char* constantVertexShader ();
   const char* constantFragmentShader ();
   const char* constantWireframeFragmentShader ();
+  const char* constantBarycentricVertexShader ();
   const char* geometryShader ();
 };
 
@@ -5,6 +5,7 @@
 #include <glm/gtx/norm.hpp>
 #include <glm/gtx/rotate_vector.hpp>
 #include "../mesh.hpp"
+#include "bvh.hpp"
 #include "color.hpp"
 #include "config.hpp"
 #include "dimension.hpp"
@@ -74,6 +75,106 @@ namespace
   private:
     PrimSphere _sphere;
   };
+
+  float maxDistance (const Intersection& intersection)
+  {
+    return intersection.isIntersection () ? intersection.distance () : Util::maxFloat ();
+  }
+
+  void extendBounds (const PrimSphere& sphere, glm::vec3& min, glm::vec3& max)
+  {
+    min = glm::min (min, sphere.center () - glm::vec3 (sphere.radius ()));
+    max = glm::max (max, sphere.center () + glm::vec3 (sphere.radius ()));
+  }
+
+  void resetBounds (glm::vec3& min, glm::vec3& max)
+  {
+    min = glm::vec3 (Util::maxFloat ());
+    max = glm::vec3 (Util::minFloat ());
+  }
+
+  /* Bounding volume hierarchies of the nodes, bones and path spheres of a sketch.
+   * A bone is identified by its child node, a path sphere by the indices of its path and itself.
+   * The hierarchies are rebuilt after the sketch's structure changed and refitted after its spheres
+   * moved or changed. Both happen lazily before the next query. Nodes that are added or deleted
+   * through the tree's nodes directly are noticed by the tree's revision.
+   */
+  struct SketchBVH
+  {
+    BVH                      nodeBVH;
+    BVH                      boneBVH;
+    BVH                      sphereBVH;
+    std::vector<SketchNode*> nodes;
+    std::vector<SketchNode*> bones;
+    std::vector<ui_pair>     spheres;
+    bool                     needsBuild;
+    bool                     needsRefit;
+    unsigned int             treeRevision;
+
+    SketchBVH ()
+      : needsBuild (true)
+      , needsRefit (false)
+      , treeRevision (0)
+    {
+    }
+
+    void update (SketchTree& tree, const SketchPaths& paths)
+    {
+      const auto nodeBounds = [this](unsigned int i, glm::vec3& min, glm::vec3& max) {
+        resetBounds (min, max);
+        extendBounds (this->nodes[i]->data (), min, max);
+      };
+
+      const auto boneBounds = [this](unsigned int i, glm::vec3& min, glm::vec3& max) {
+        resetBounds (min, max);
+        extendBounds (this->bones[i]->data (), min, max);
+        extendBounds (this->bones[i]->parent ()->data (), min, max);
+      };
+
+      const auto sphereBounds = [this, &paths](unsigned int i, glm::vec3& min, glm::vec3& max) {
+        resetBounds (min, max);
+        extendBounds (paths[this->spheres[i].first].spheres ()[this->spheres[i].second], min, max);
+      };
+
+      if (this->needsBuild || this->treeRevision != tree.revision ())
+      {
+        this->nodes.clear ();
+        this->bones.clear ();
+        this->spheres.clear ();
+
+        if (tree.hasRoot ())
+        {
+          tree.root ().forEachNode ([this](SketchNode& node) {
+            this->nodes.push_back (&node);
+
+            if (node.parent ())
+            {
+              this->bones.push_back (&node);
+            }
+          });
+        }
+        for (unsigned int i = 0; i < paths.size (); i++)
+        {
+          for (unsigned int j = 0; j < paths[i].spheres ().size (); j++)
+          {
+            this->spheres.emplace_back (i, j);
+          }
+        }
+        this->nodeBVH.build (this->nodes.size (), nodeBounds);
+        this->boneBVH.build (this->bones.size (), boneBounds);
+        this->sphereBVH.build (this->spheres.size (), sphereBounds);
+      }
+      else if (this->needsRefit)
+      {
+        this->nodeBVH.refit (nodeBounds);
+        this->boneBVH.refit (boneBounds);
+        this->sphereBVH.refit (sphereBounds);
+      }
+      this->needsBuild = false;
+      this->needsRefit = false;
+      this->treeRevision = tree.revision ();
+    }
+  };
 }
 
 struct SketchMesh::Impl
@@ -84,9 +185,18 @@ struct SketchMesh::Impl
   Mesh         sphereMesh;
   Mesh         boneMesh;
   RenderConfig renderConfig;
+  SketchBVH    bvh;
+
+  // cached bounds, cf. `minMax`
+  mutable bool         hasBounds;
+  mutable glm::vec3    minimum;
+  mutable glm::vec3    maximum;
+  mutable unsigned int boundsRevision;
 
   Impl (SketchMesh* s)
     : self (s)
+    , hasBounds (false)
+    , boundsRevision (0)
   {
     this->sphereMesh = MeshUtil::icosphere (3);
     this->sphereMesh.bufferData ();
@@ -105,6 +215,8 @@ struct SketchMesh::Impl
     , sphereMesh (other.sphereMesh)
     , boneMesh (other.boneMesh)
     , renderConfig (other.renderConfig)
+    , hasBounds (false)
+    , boundsRevision (0)
   {
     this->sphereMesh.bufferData ();
     this->boneMesh.bufferData ();
@@ -112,53 +224,75 @@ struct SketchMesh::Impl
 
   bool isEmpty () const { return this->tree.hasRoot () == false && this->paths.empty (); }
 
-  void fromTree (const SketchTree& newTree) { this->tree = newTree; }
+  // invalidates the BVHs and bounds after the sketch's structure changed
+  void structureChanged ()
+  {
+    this->bvh.needsBuild = true;
+    this->hasBounds = false;
+  }
+
+  // invalidates the BVHs and bounds after spheres moved or changed
+  void spheresChanged ()
+  {
+    this->bvh.needsRefit = true;
+    this->hasBounds = false;
+  }
 
-  void reset () { this->tree.reset (); }
+  void fromTree (const SketchTree& newTree)
+  {
+    this->tree = newTree;
+    this->structureChanged ();
+  }
+
+  void reset ()
+  {
+    this->tree.reset ();
+    this->structureChanged ();
+  }
 
   bool intersects (const PrimRay& ray, SketchNodeIntersection& intersection,
                    const SketchNode* exclude = nullptr)
   {
-    if (this->tree.hasRoot ())
-    {
-      this->tree.root ().forEachNode ([this, &ray, &intersection, exclude](SketchNode& node) {
-        float t;
+    this->bvh.update (this->tree, this->paths);
+    this->bvh.nodeBVH.intersects (
+      ray, maxDistance (intersection), [this, &ray, &intersection, exclude](unsigned int i) {
+        SketchNode& node = *this->bvh.nodes[i];
+        float       t;
+
         if (&node != exclude && IntersectionUtil::intersects (ray, node.data (), &t))
         {
           const glm::vec3 p = ray.pointAt (t);
           intersection.update (t, p, glm::normalize (p - node.data ().center ()), *this->self,
                                node);
         }
+        return maxDistance (intersection);
       });
-    }
     return intersection.isIntersection ();
   }
 
   bool intersects (const PrimRay& ray, SketchBoneIntersection& intersection)
   {
-    if (this->tree.hasRoot ())
-    {
-      this->tree.root ().forEachNode ([this, &ray, &intersection](SketchNode& node) {
-        if (node.parent ())
+    this->bvh.update (this->tree, this->paths);
+    this->bvh.boneBVH.intersects (
+      ray, maxDistance (intersection), [this, &ray, &intersection](unsigned int i) {
+        SketchNode&          node = *this->bvh.bones[i];
+        const PrimConeSphere coneSphere (node.data (), node.parent ()->data ());
+
+        if (coneSphere.hasCone ())
         {
-          const PrimConeSphere coneSphere (node.data (), node.parent ()->data ());
+          const PrimCone cone = coneSphere.toCone ();
 
-          if (coneSphere.hasCone ())
+          float tRay, tCone;
+          if (IntersectionUtil::intersects (ray, cone, &tRay, &tCone))
           {
-            const PrimCone cone = coneSphere.toCone ();
+            const glm::vec3 p = ray.pointAt (tRay);
 
-            float tRay, tCone;
-            if (IntersectionUtil::intersects (ray, cone, &tRay, &tCone))
-            {
-              const glm::vec3 p = ray.pointAt (tRay);
-
-              intersection.update (tRay, p, cone.projPointAt (tCone), cone.normalAt (p, tCone),
-                                   *this->self, node);
-            }
+            intersection.update (tRay, p, cone.projPointAt (tCone), cone.normalAt (p, tCone),
+                                 *this->self, node);
           }
         }
+        return maxDistance (intersection);
       });
-    }
     return intersection.isIntersection ();
   }
 
@@ -179,37 +313,53 @@ struct SketchMesh::Impl
       intersection.update (sbIntersection.distance (), sbIntersection.position (),
                            sbIntersection.normal (), sbIntersection.mesh ());
     }
-    if (numExcludedLastPaths < this->paths.size ())
+    if (numExcludedLastPaths < this->paths.size () &&
+        this->intersects (ray, spIntersection, this->paths.size () - numExcludedLastPaths))
     {
-      for (unsigned int i = 0; i < this->paths.size () - numExcludedLastPaths; i++)
-      {
-        if (this->paths.at (i).intersects (ray, *this->self, spIntersection))
+      intersection.update (spIntersection.distance (), spIntersection.position (),
+                           spIntersection.normal (), spIntersection.mesh ());
+    }
+    return intersection.isIntersection ();
+  }
+
+  // only the spheres of the first `numPaths` paths are intersected
+  bool intersects (const PrimRay& ray, SketchPathIntersection& intersection, unsigned int numPaths)
+  {
+    this->bvh.update (this->tree, this->paths);
+    this->bvh.sphereBVH.intersects (
+      ray, maxDistance (intersection), [this, &ray, &intersection, numPaths](unsigned int i) {
+        const ui_pair& index = this->bvh.spheres[i];
+
+        if (index.first < numPaths)
         {
-          intersection.update (spIntersection.distance (), spIntersection.position (),
-                               spIntersection.normal (), spIntersection.mesh ());
+          SketchPath&       path = this->paths[index.first];
+          const PrimSphere& sphere = path.spheres ()[index.second];
+          float             t;
+
+          if (IntersectionUtil::intersects (ray, sphere, &t))
+          {
+            const glm::vec3 p = ray.pointAt (t);
+            intersection.update (t, p, glm::normalize (p - sphere.center ()), *this->self, path);
+          }
         }
-      }
-    }
+        return maxDistance (intersection);
+      });
     return intersection.isIntersection ();
   }
 
   bool intersects (const PrimRay& ray, SketchPathIntersection& intersection)
   {
-    for (unsigned int i = 0; i < this->paths.size (); i++)
-    {
-      this->paths.at (i).intersects (ray, *this->self, intersection);
-    }
-    return intersection.isIntersection ();
+    return this->intersects (ray, intersection, this->paths.size ());
   }
 
   bool intersects (const glm::vec3& point, PrimSphereIntersection& intersection,
                    const SketchPath& excluded)
   {
-    auto checkSphere = [&point, &intersection](const SketchNode& node) {
-      const float d2 = glm::distance2 (point, node.data ().center ());
-      if (d2 <= node.data ().radius () * node.data ().radius ())
+    auto checkSphere = [&point, &intersection](const PrimSphere& sphere) {
+      const float d2 = glm::distance2 (point, sphere.center ());
+      if (d2 <= sphere.radius () * sphere.radius ())
       {
-        intersection.update (glm::sqrt (d2), node.data ());
+        intersection.update (glm::sqrt (d2), sphere);
       }
     };
 
@@ -267,25 +417,28 @@ struct SketchMesh::Impl
       }
       else
       {
-        checkSphere (node);
+        checkSphere (node.data ());
       }
     };
 
+    this->bvh.update (this->tree, this->paths);
+
     if (this->tree.hasRoot ())
     {
-      this->tree.root ().forEachNode ([&checkBone](SketchNode& node) { checkBone (node); });
+      checkBone (this->tree.root ());
     }
+    this->bvh.boneBVH.intersects (
+      point, [this, &checkBone](unsigned int i) { checkBone (*this->bvh.bones[i]); });
 
-    for (const SketchPath& p : this->paths)
-    {
-      if (&p != &excluded)
+    this->bvh.sphereBVH.intersects (point, [this, &excluded, &checkSphere](unsigned int i) {
+      const ui_pair&    index = this->bvh.spheres[i];
+      const SketchPath& path = this->paths[index.first];
+
+      if (&path != &excluded)
       {
-        for (const PrimSphere& s : p.spheres ())
-        {
-          checkSphere (s);
-        }
+        checkSphere (path.spheres ()[index.second]);
       }
-    }
+    });
     return intersection.isIntersection ();
   }
 
@@ -451,6 +604,8 @@ struct SketchMesh::Impl
   SketchNode& addChild (SketchNode& parent, const glm::vec3& pos, float radius,
                         const Dimension* dim)
   {
+    this->structureChanged ();
+
     SketchNode& newNode = parent.emplaceChild (pos, radius);
 
     if (dim)
@@ -463,6 +618,8 @@ struct SketchMesh::Impl
   SketchNode& addParent (SketchNode& child, const glm::vec3& pos, float radius,
                          const Dimension* dim)
   {
+    this->structureChanged ();
+
     assert (child.parent ());
 
     SketchNode& newNode = child.parent ()->emplaceChild (pos, radius);
@@ -489,6 +646,8 @@ struct SketchMesh::Impl
 
   SketchPath& addPath (const SketchPath& path)
   {
+    this->structureChanged ();
+
     this->paths.push_back (path);
     return this->paths.back ();
   }
@@ -496,6 +655,8 @@ struct SketchMesh::Impl
   void addSphere (bool newPath, const glm::vec3& intersection, const glm::vec3& position,
                   float radius, const Dimension* dim)
   {
+    this->structureChanged ();
+
     if (newPath)
     {
       this->paths.emplace_back ();
@@ -517,6 +678,8 @@ struct SketchMesh::Impl
 
   void move (SketchNode& node, const glm::vec3& delta, bool all, const Dimension* dim)
   {
+    this->spheresChanged ();
+
     const auto moveNodes = [all](SketchNode& node, const glm::vec3& delta) {
       if (all)
       {
@@ -549,6 +712,8 @@ struct SketchMesh::Impl
 
   void scale (SketchNode& node, float factor, bool all, const Dimension* dim)
   {
+    this->spheresChanged ();
+
     const auto scaleNodes = [factor, all](SketchNode& node) {
       if (all)
       {
@@ -580,6 +745,8 @@ struct SketchMesh::Impl
 
   void rotate (SketchNode& node, const glm::vec3& axis, float angle, const Dimension* dim)
   {
+    this->spheresChanged ();
+
     const auto rotateNodes = [](SketchNode& node, const glm::vec3& axis, float angle) {
       const glm::mat4x4 matrix = Util::rotation (node.data ().center (), axis, angle);
 
@@ -608,6 +775,8 @@ struct SketchMesh::Impl
 
   void deleteNode (SketchNode& node, bool deleteChildren, const Dimension* dim)
   {
+    this->structureChanged ();
+
     assert (this->tree.hasRoot ());
 
     if (node.parent () == nullptr)
@@ -647,6 +816,8 @@ struct SketchMesh::Impl
 
   void deletePath (SketchPath& path, const Dimension* dim)
   {
+    this->structureChanged ();
+
     assert (this->paths.empty () == false);
 
     if (dim && this->paths.size () >= 2)
@@ -744,18 +915,24 @@ struct SketchMesh::Impl
 
   void mirror (Dimension dim)
   {
+    this->structureChanged ();
+
     this->mirrorTree (dim);
     this->mirrorPaths (dim);
   }
 
   void rebalance (SketchNode& newRoot)
   {
+    this->structureChanged ();
+
     assert (this->tree.hasRoot ());
     this->tree.rebalance (newRoot);
   }
 
   SketchNode& snap (SketchNode& node, Dimension dim)
   {
+    this->structureChanged ();
+
     assert (this->tree.hasRoot ());
     const PrimPlane mPlane = this->mirrorPlane (dim);
 
@@ -789,21 +966,30 @@ struct SketchMesh::Impl
 
   void minMax (glm::vec3& min, glm::vec3& max) const
   {
-    min = glm::vec3 (Util::maxFloat ());
-    max = glm::vec3 (Util::minFloat ());
-
-    if (this->tree.hasRoot ())
-    {
-      this->tree.root ().forEachConstNode ([&min, &max](const SketchNode& node) {
-        min = glm::min (min, node.data ().center () - glm::vec3 (node.data ().radius ()));
-        max = glm::max (max, node.data ().center () + glm::vec3 (node.data ().radius ()));
-      });
-    }
-    for (const SketchPath& p : this->paths)
+    if (this->hasBounds == false || this->boundsRevision != this->tree.revision ())
     {
-      min = glm::min (min, p.minimum ());
-      max = glm::max (max, p.maximum ());
+      this->minimum = glm::vec3 (Util::maxFloat ());
+      this->maximum = glm::vec3 (Util::minFloat ());
+
+      if (this->tree.hasRoot ())
+      {
+        this->tree.root ().forEachConstNode ([this](const SketchNode& node) {
+          const glm::vec3 radius (node.data ().radius ());
+
+          this->minimum = glm::min (this->minimum, node.data ().center () - radius);
+          this->maximum = glm::max (this->maximum, node.data ().center () + radius);
+        });
+      }
+      for (const SketchPath& p : this->paths)
+      {
+        this->minimum = glm::min (this->minimum, p.minimum ());
+        this->maximum = glm::max (this->maximum, p.maximum ());
+      }
+      this->hasBounds = true;
+      this->boundsRevision = this->tree.revision ();
     }
+    min = this->minimum;
+    max = this->maximum;
   }
 
   void smoothPath (SketchPath& path, const PrimSphere& range, unsigned int halfWidth,
@@ -836,74 +1022,60 @@ struct SketchMesh::Impl
       path.smooth (range, halfWidth, effect,
                    intersection1.isIntersection () ? &intersection1.sphere () : nullptr,
                    intersection2.isIntersection () ? &intersection2.sphere () : nullptr);
+      this->spheresChanged ();
     }
   }
 
+  // deletes path spheres that are contained in spheres of other paths or in bones.
+  // Deleted spheres are marked first, so the result does not depend on the order of paths.
   void optimizePaths ()
   {
-    for (SketchPath& p1 : this->paths)
+    this->bvh.update (this->tree, this->paths);
+
+    std::vector<std::vector<bool>> deleted;
+
+    for (const SketchPath& p : this->paths)
     {
-      for (SketchPath& p2 : this->paths)
-      {
-        if (&p1 < &p2)
-        {
-          for (auto it1 = p1.spheres ().begin (); it1 != p1.spheres ().end ();)
-          {
-            bool deletedP1Sphere = false;
+      deleted.emplace_back (p.spheres ().size (), false);
+    }
 
-            for (auto it2 = p2.spheres ().begin (); it2 != p2.spheres ().end ();)
-            {
-              const PrimSphere& s1 = *it1;
-              const PrimSphere& s2 = *it2;
-              const float       d = glm::distance (s1.center (), s2.center ());
+    for (const ui_pair& index1 : this->bvh.spheres)
+    {
+      const PrimSphere& s1 = this->paths[index1.first].spheres ()[index1.second];
+      bool              isDeleted = false;
 
-              if (s2.radius () > d + s1.radius ())
-              {
-                it1 = p1.deleteSphere (it1);
-                deletedP1Sphere = true;
-                break;
-              }
-              else if (s1.radius () > d + s2.radius ())
-              {
-                it2 = p2.deleteSphere (it2);
-              }
-              else
-              {
-                ++it2;
-              }
-            }
-            if (deletedP1Sphere == false)
-            {
-              ++it1;
-            }
+      // a sphere containing `s1` also contains its center
+      this->bvh.sphereBVH.intersects (
+        s1.center (), [this, &index1, &s1, &isDeleted](unsigned int i) {
+          const ui_pair&    index2 = this->bvh.spheres[i];
+          const PrimSphere& s2 = this->paths[index2.first].spheres ()[index2.second];
+
+          if (index1.first != index2.first &&
+              s2.radius () > glm::distance (s1.center (), s2.center ()) + s1.radius ())
+          {
+            isDeleted = true;
           }
+        });
+
+      this->bvh.boneBVH.intersects (s1.center (), [this, &s1, &isDeleted](unsigned int i) {
+        const SketchNode&    node = *this->bvh.bones[i];
+        const PrimConeSphere coneSphere (node.data (), node.parent ()->data ());
+
+        if (Distance::distance (coneSphere, s1.center ()) < -s1.radius ())
+        {
+          isDeleted = true;
         }
-      }
-      if (this->tree.hasRoot ())
-      {
-        this->tree.root ().forEachNode ([&p1](SketchNode& node) {
-          if (node.parent ())
-          {
-            const PrimConeSphere coneSphere (node.data (), node.parent ()->data ());
+      });
 
-            for (auto it1 = p1.spheres ().begin (); it1 != p1.spheres ().end ();)
-            {
-              const PrimSphere& s1 = *it1;
-              const float       d = Distance::distance (coneSphere, s1.center ());
+      deleted[index1.first][index1.second] = isDeleted;
+    }
 
-              if (d < -s1.radius ())
-              {
-                it1 = p1.deleteSphere (it1);
-              }
-              else
-              {
-                ++it1;
-              }
-            }
-          }
-        });
-      }
+    for (unsigned int i = 0; i < this->paths.size (); i++)
+    {
+      this->paths[i].filterSpheres (
+        [&deleted, i](unsigned int j) { return deleted[i][j] == false; });
     }
+    this->structureChanged ();
   }
 
   void runFromConfig (const Config& config)
@@ -916,7 +1088,6 @@ struct SketchMesh::Impl
 
 DELEGATE_BIG4_COPY_SELF (SketchMesh);
 GETTER_CONST (const SketchTree&, SketchMesh, tree)
-GETTER (SketchTree&, SketchMesh, tree)
 GETTER_CONST (const SketchPaths&, SketchMesh, paths)
 DELEGATE_CONST (bool, SketchMesh, isEmpty)
 DELEGATE1 (void, SketchMesh, fromTree, const SketchTree&)
@@ -948,3 +1119,10 @@ DELEGATE5 (void, SketchMesh, smoothPath, SketchPath&, const PrimSphere&, unsigne
            SketchPathSmoothEffect, const Dimension*)
 DELEGATE (void, SketchMesh, optimizePaths)
 DELEGATE1 (void, SketchMesh, runFromConfig, const Config&)
+
+SketchTree& SketchMesh::tree ()
+{
+  // the tree's structure may be changed by the caller
+  this->impl->structureChanged ();
+  return this->impl->tree;
+}
@@ -70,9 +70,20 @@ struct SketchPath::Impl
     this->spheres.emplace_back (position, radius);
   }
 
-  SketchPath::Spheres::iterator deleteSphere (SketchPath::Spheres::const_iterator it)
+  // keeps the spheres whose indices satisfy `f`
+  void filterSpheres (const std::function<bool(unsigned int)>& f)
   {
-    return this->spheres.erase (it);
+    unsigned int n = 0;
+
+    for (unsigned int i = 0; i < this->spheres.size (); i++)
+    {
+      if (f (i))
+      {
+        this->spheres[n++] = this->spheres[i];
+      }
+    }
+    this->spheres.erase (this->spheres.begin () + n, this->spheres.end ());
+    this->setMinMax ();
   }
 
   void render (Camera& camera, Mesh& mesh) const
@@ -230,8 +241,7 @@ DELEGATE (void, SketchPath, reset)
 DELEGATE_CONST (bool, SketchPath, isEmpty)
 DELEGATE_CONST (PrimAABox, SketchPath, aabox)
 DELEGATE3 (void, SketchPath, addSphere, const glm::vec3&, const glm::vec3&, float)
-DELEGATE1 (SketchPath::Spheres::iterator, SketchPath, deleteSphere,
-           SketchPath::Spheres::const_iterator)
+DELEGATE1 (void, SketchPath, filterSpheres, const std::function<bool(unsigned int)>&)
 DELEGATE2_CONST (void, SketchPath, render, Camera&, Mesh&)
 DELEGATE3 (bool, SketchPath, intersects, const PrimRay&, SketchMesh&, SketchPathIntersection&)
 DELEGATE1 (SketchPath, SketchPath, mirror, const PrimPlane&)
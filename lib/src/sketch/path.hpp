@@ -5,6 +5,7 @@
 #ifndef DILAY_SKETCH_PATH
 #define DILAY_SKETCH_PATH
 
+#include <functional>
 #include <glm/fwd.hpp>
 #include "macro.hpp"
 #include "sketch/fwd.hpp"
@@ -42,7 +43,7 @@ public:
   bool              isEmpty () const;
   PrimAABox         aabox () const;
   void              addSphere (const glm::vec3&, const glm::vec3&, float);
-  Spheres::iterator deleteSphere (Spheres::const_iterator);
+  void              filterSpheres (const std::function<bool(unsigned int)>&);
   void              render (Camera&, Mesh&) const;
   bool              intersects (const PrimRay&, SketchMesh&, SketchPathIntersection&);
   SketchPath        mirror (const PrimPlane&);
@@ -342,6 +342,9 @@ struct State::Impl
       case ToolResponse::Redraw:
         this->mainWindow.update ();
         break;
+      case ToolResponse::RedrawOverlay:
+        this->mainWindow.glWidget ().updateOverlay ();
+        break;
       case ToolResponse::Terminate:
         this->resetTool ();
         break;
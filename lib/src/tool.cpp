@@ -8,6 +8,7 @@
 #include "cache.hpp"
 #include "camera.hpp"
 #include "dimension.hpp"
+#include "dynamic/mesh-intersection.hpp"
 #include "dynamic/mesh.hpp"
 #include "history.hpp"
 #include "intersection.hpp"
@@ -317,6 +318,30 @@ struct Tool::Impl
     return this->intersectsScene (e.position (), intersection, std::forward<Ts> (args)...);
   }
 
+  // answered by the pick buffer if it is enabled, which is cheaper but less precise
+  bool pickScene (const glm::ivec2& pos, glm::vec3& position)
+  {
+    ViewGlWidget& glWidget = this->state.mainWindow ().glWidget ();
+
+    if (glWidget.usePickBuffer ())
+    {
+      return glWidget.pick (pos, position) != nullptr;
+    }
+    else
+    {
+      DynamicMeshIntersection intersection;
+      if (this->intersectsScene (pos, intersection))
+      {
+        position = intersection.position ();
+        return true;
+      }
+      else
+      {
+        return false;
+      }
+    }
+  }
+
   ToolResponse runPointingEvent (const ViewPointingEvent& e)
   {
     if (e.pressEvent ())
@@ -366,6 +391,7 @@ DELEGATE (void, Tool, addMirrorProperties)
 DELEGATE1 (void, Tool, enableMirrorProperties, bool)
 DELEGATE1 (void, Tool, addMoveOnPrimaryPlaneProperties, ToolUtilMovement&)
 DELEGATE1_CONST (bool, Tool, onKeymap, char)
+DELEGATE2 (bool, Tool, pickScene, const glm::ivec2&, glm::vec3&)
 DELEGATE1 (ToolResponse, Tool, runPointingEvent, const ViewPointingEvent&)
 
 template <typename T, typename... Ts>
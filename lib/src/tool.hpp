@@ -29,7 +29,8 @@ enum class ToolResponse
 {
   None,
   Terminate,
-  Redraw
+  Redraw,
+  RedrawOverlay
 };
 
 class Tool
@@ -71,6 +72,7 @@ protected:
   void               enableMirrorProperties (bool = true);
   void               addMoveOnPrimaryPlaneProperties (ToolUtilMovement&);
   bool               onKeymap (char) const;
+  bool               pickScene (const glm::ivec2&, glm::vec3&);
 
   template <typename T, typename... Ts> bool intersectsScene (const PrimRay&, T&, Ts...);
   template <typename T, typename... Ts> bool intersectsScene (const glm::ivec2&, T&, Ts...);
@@ -2,13 +2,16 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <QTimer>
 #include <QWheelEvent>
 #include <glm/gtc/constants.hpp>
 #include "camera.hpp"
 #include "config.hpp"
 #include "dimension.hpp"
 #include "intersection.hpp"
+#include "scene.hpp"
 #include "state.hpp"
+#include "tool/sculpt.hpp"
 #include "tools.hpp"
 #include "view/floor-plane.hpp"
 #include "view/gl-widget.hpp"
@@ -25,12 +28,22 @@ struct ToolMoveCamera::Impl
   float           rotationFactor;
   float           movementFactor;
   float           zoomInMouseWheelFactor;
+  QTimer          wheelTimer;
 
   Impl (ToolMoveCamera* s, bool i)
     : self (s)
     , isImmediateTool (i)
     , oldPos (s->state ().mainWindow ().glWidget ().cursorPosition ())
   {
+    // wheel events have no release event, so navigation ends once the wheel rests
+    this->wheelTimer.setSingleShot (true);
+    this->wheelTimer.setInterval (250);
+    QObject::connect (&this->wheelTimer, &QTimer::timeout, [this]() {
+      if (this->stopNavigating ())
+      {
+        this->self->state ().mainWindow ().glWidget ().update ();
+      }
+    });
   }
 
   Impl (ToolMoveCamera* s)
@@ -63,6 +76,31 @@ struct ToolMoveCamera::Impl
     this->self->state ().setToolTip (&toolTip, {exitShortcut});
   }
 
+  // sculpt tools edit the full mesh, so its proxies are never rendered while one is active
+  void startNavigating ()
+  {
+    State& state = this->self->state ();
+
+    if (state.hasTool () == false || dynamic_cast<ToolSculpt*> (&state.tool ()) == nullptr)
+    {
+      state.scene ().navigating (true);
+    }
+  }
+
+  bool stopNavigating ()
+  {
+    Scene& scene = this->self->state ().scene ();
+
+    this->wheelTimer.stop ();
+
+    if (scene.navigating ())
+    {
+      scene.navigating (false);
+      return true;
+    }
+    return false;
+  }
+
   bool mouseButton (const ViewPointingEvent& e)
   {
     return this->isImmediateTool ? e.middleButton () : e.leftButton ();
@@ -108,6 +146,7 @@ struct ToolMoveCamera::Impl
         }
         this->self->state ().mainWindow ().glWidget ().floorPlane ().update (cam);
       }
+      this->startNavigating ();
       this->oldPos = e.position ();
       return ToolResponse::Redraw;
     }
@@ -133,6 +172,11 @@ struct ToolMoveCamera::Impl
     return ToolResponse::None;
   }
 
+  ToolResponse runReleaseEvent (const ViewPointingEvent&)
+  {
+    return this->stopNavigating () ? ToolResponse::Redraw : ToolResponse::None;
+  }
+
   void runFromConfig ()
   {
     const Config& config = this->self->config ();
@@ -158,6 +202,8 @@ struct ToolMoveCamera::Impl
         camera.stepAlongGaze (1.0f / this->zoomInMouseWheelFactor);
       }
       this->self->state ().mainWindow ().glWidget ().floorPlane ().update (camera);
+      this->startNavigating ();
+      this->wheelTimer.start ();
       return ToolResponse::Redraw;
     }
     return ToolResponse::None;
@@ -216,6 +262,7 @@ DELEGATE_CONSTRUCTOR_BASE (ToolMoveCamera, (State & s, bool i), (this, i), Tool,
 DELEGATE_TOOL (ToolMoveCamera)
 DELEGATE_TOOL_RUN_MOVE_EVENT (ToolMoveCamera)
 DELEGATE_TOOL_RUN_PRESS_EVENT (ToolMoveCamera)
+DELEGATE_TOOL_RUN_RELEASE_EVENT (ToolMoveCamera)
 DELEGATE_TOOL_RUN_FROM_CONFIG (ToolMoveCamera)
 DELEGATE1 (ToolResponse, ToolMoveCamera, wheelEvent, const QWheelEvent&)
 DELEGATE (void, ToolMoveCamera, snap)
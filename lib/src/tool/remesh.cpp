@@ -8,6 +8,7 @@
 #include "config.hpp"
 #include "dynamic/mesh-intersection.hpp"
 #include "dynamic/mesh.hpp"
+#include "intersection.hpp"
 #include "isosurface-extraction.hpp"
 #include "maybe.hpp"
 #include "mesh.hpp"
@@ -17,6 +18,7 @@
 #include "state.hpp"
 #include "tool/sculpt/util/action.hpp"
 #include "tools.hpp"
+#include "util.hpp"
 #include "view/pointing-event.hpp"
 #include "view/resolution-slider.hpp"
 #include "view/tool-tip.hpp"
@@ -32,6 +34,91 @@ namespace
     Difference,
     Intersection
   };
+
+  typedef std::vector<Intersection> Intersections;
+
+  bool isInside (Mode mode, bool insideA, bool insideB)
+  {
+    switch (mode)
+    {
+      case Mode::Union:
+        return insideA || insideB;
+      case Mode::Difference:
+        return insideA && insideB == false;
+      case Mode::Intersection:
+        return insideA && insideB;
+      default:
+        DILAY_IMPOSSIBLE
+    }
+  }
+
+  // each intersection enters or leaves the mesh: intersections that are nearer to their
+  // predecessor than `Util::epsilon ()` hit a shared edge or vertex and are skipped
+  void crossings (const Intersections& intersections, std::vector<float>& distances)
+  {
+    distances.clear ();
+
+    for (const Intersection& i : intersections)
+    {
+      if (distances.empty () || i.distance () >= distances.back () + Util::epsilon ())
+      {
+        distances.push_back (i.distance ());
+      }
+    }
+  }
+
+  // the ray enters or leaves the combination of both meshes whenever its inside state changes
+  void crossings (const PrimRay& ray, const Intersections& intersectionsA,
+                  const Intersections& intersectionsB, Mode mode, std::vector<float>& distances)
+  {
+    bool insideA = false;
+    bool insideB = false;
+    bool inside = false;
+    auto a = intersectionsA.begin ();
+    auto b = intersectionsB.begin ();
+
+    const auto aEnd = intersectionsA.end ();
+    const auto bEnd = intersectionsB.end ();
+
+    distances.clear ();
+
+    while (a != aEnd || b != bEnd)
+    {
+      const bool          isA = b == bEnd || (a != aEnd && a->distance () < b->distance ());
+      const Intersection& i = isA ? *a++ : *b++;
+      const bool          enters = glm::dot (ray.direction (), i.normal ()) < 0.0f;
+
+      if (isA)
+      {
+        insideA = enters;
+      }
+      else
+      {
+        insideB = enters;
+      }
+
+      if (isInside (mode, insideA, insideB) != inside)
+      {
+        inside = not inside;
+        distances.push_back (i.distance ());
+      }
+    }
+  }
+
+  // a packet only pays off if it has more than one ray, i.e. a single ray is intersected alone
+  void intersectsAll (const DynamicMesh& mesh, const std::vector<PrimRay>& rays,
+                      std::vector<Intersections>& intersections)
+  {
+    if (rays.size () == 1)
+    {
+      intersections.resize (1);
+      mesh.intersectsAll (rays[0], intersections[0], true);
+    }
+    else
+    {
+      mesh.intersectsAll (rays, intersections, true);
+    }
+  }
 }
 
 struct ToolRemesh::Impl
@@ -92,15 +179,15 @@ struct ToolRemesh::Impl
 
   void remesh (DynamicMesh& mesh)
   {
-    const IsosurfaceExtraction::IntersectionCallback getIntersection =
-      [&mesh](const PrimRay& ray, Intersection& intersection) {
-        if (mesh.intersects (ray, intersection, true))
-        {
-          return IsosurfaceExtraction::Intersection::Sample;
-        }
-        else
+    const IsosurfaceExtraction::IntersectionCallback getIntersections =
+      [&mesh](const std::vector<PrimRay>& rays, std::vector<std::vector<float>>& distances) {
+        std::vector<Intersections> intersections;
+        intersectsAll (mesh, rays, intersections);
+
+        distances.resize (rays.size ());
+        for (unsigned int i = 0; i < rays.size (); i++)
         {
-          return IsosurfaceExtraction::Intersection::None;
+          crossings (intersections[i], distances[i]);
         }
       };
 
@@ -110,7 +197,7 @@ struct ToolRemesh::Impl
 
     const PrimAABox bounds = mesh.mesh ().bounds ();
     DynamicMesh     extractedMesh;
-    IsosurfaceExtraction::extract (getDistance, getIntersection, bounds, this->resolution,
+    IsosurfaceExtraction::extract (getDistance, getIntersections, bounds, this->resolution,
                                    extractedMesh);
 
     State& state = this->self->state ();
@@ -121,182 +208,20 @@ struct ToolRemesh::Impl
 
   void remesh (DynamicMesh& meshA, DynamicMesh& meshB)
   {
-    const IsosurfaceExtraction::IntersectionCallback getCommutativeIntersection =
-      [this, &meshA, &meshB](const PrimRay& ray, Intersection& intersection) {
-        assert (this->mode == Mode::Union || this->mode == Mode::Intersection);
-
-        Intersection intersectionA, intersectionB;
-        meshA.intersects (ray, intersectionA, true);
-        meshB.intersects (ray, intersectionB, true);
-
-        Intersection::sort (intersectionA, intersectionB);
-        intersection = intersectionA;
-
-        const bool intersectsA = intersectionA.isIntersection ();
-        const bool intersectsB = intersectionB.isIntersection ();
-
-        if (intersectsA && intersectsB)
-        {
-          const bool insideA = glm::dot (ray.direction (), intersectionA.normal ()) > 0.0f;
-          const bool insideB = glm::dot (ray.direction (), intersectionB.normal ()) > 0.0f;
+    assert (this->mode != Mode::Normal);
 
-          if (insideA && insideB)
-          {
-            // (B (A o-> A) B)
-            // (A (B o-> A) B)
-            if (this->mode == Mode::Union)
-            {
-              return IsosurfaceExtraction::Intersection::Continue;
-            }
-            else
-            {
-              assert (this->mode == Mode::Intersection);
-              return IsosurfaceExtraction::Intersection::Sample;
-            }
-          }
-          else if (insideA && insideB == false)
-          {
-            // (A o-> A) (B B)
-            if (this->mode == Mode::Union)
-            {
-              return IsosurfaceExtraction::Intersection::Sample;
-            }
-            else
-            {
-              assert (this->mode == Mode::Intersection);
-              return IsosurfaceExtraction::Intersection::Continue;
-            }
-          }
-          else if (insideA == false && insideB)
-          {
-            // (B o-> (A A) B)
-            // (B o-> (A B) A)
-            if (this->mode == Mode::Union)
-            {
-              return IsosurfaceExtraction::Intersection::Continue;
-            }
-            else
-            {
-              assert (this->mode == Mode::Intersection);
-              return IsosurfaceExtraction::Intersection::Sample;
-            }
-          }
-          else if (insideA == false && insideB == false)
-          {
-            // o-> (A (B B) A)
-            // o-> (A (B A) B)
-            // o-> (A A) (B B)
-            if (this->mode == Mode::Union)
-            {
-              return IsosurfaceExtraction::Intersection::Sample;
-            }
-            else
-            {
-              assert (this->mode == Mode::Intersection);
-              return IsosurfaceExtraction::Intersection::Continue;
-            }
-          }
-          DILAY_IMPOSSIBLE
-        }
-        else if (intersectsA)
-        {
-          if (this->mode == Mode::Union)
-          {
-            return IsosurfaceExtraction::Intersection::Sample;
-          }
-          else
-          {
-            assert (this->mode == Mode::Intersection);
-            return IsosurfaceExtraction::Intersection::Continue;
-          }
-        }
-        else
-        {
-          assert (intersectsB == false);
-          return IsosurfaceExtraction::Intersection::None;
-        }
-        DILAY_IMPOSSIBLE
-      };
+    const IsosurfaceExtraction::IntersectionCallback getIntersections =
+      [this, &meshA, &meshB](const std::vector<PrimRay>&       rays,
+                             std::vector<std::vector<float>>& distances) {
+        std::vector<Intersections> intersectionsA, intersectionsB;
+        intersectsAll (meshA, rays, intersectionsA);
+        intersectsAll (meshB, rays, intersectionsB);
 
-    const IsosurfaceExtraction::IntersectionCallback getDifferenceIntersection =
-      [this, &meshA, &meshB](const PrimRay& ray, Intersection& intersection) {
-        assert (this->mode == Mode::Difference);
-
-        Intersection intersectionA, intersectionB;
-        const bool   intersectsA = meshA.intersects (ray, intersectionA, true);
-        const bool   intersectsB = meshB.intersects (ray, intersectionB, true);
-
-        if (intersectsA && intersectsB)
+        distances.resize (rays.size ());
+        for (unsigned int i = 0; i < rays.size (); i++)
         {
-          const bool insideA = glm::dot (ray.direction (), intersectionA.normal ()) > 0.0f;
-          const bool insideB = glm::dot (ray.direction (), intersectionB.normal ()) > 0.0f;
-          const bool aBeforeB = intersectionA.distance () < intersectionB.distance ();
-
-          intersection = aBeforeB ? intersectionA : intersectionB;
-
-          if (insideA && insideB)
-          {
-            if (aBeforeB)
-            {
-              // (B (A o-> A) B)
-              // (A (B o-> A) B)
-              return IsosurfaceExtraction::Intersection::Continue;
-            }
-            else
-            {
-              // (A (B o-> B) A)
-              // (B (A o-> B) A)
-              return IsosurfaceExtraction::Intersection::Sample;
-            }
-          }
-          else if (insideA && insideB == false)
-          {
-            // (A o-> A) (B B)
-            // (A o-> (B B) A)
-            // (A o-> (B A) B)
-            return IsosurfaceExtraction::Intersection::Sample;
-          }
-          else if (insideA == false && insideB)
-          {
-            // (B o-> B) (A A)
-            // (B o-> (A A) B)
-            // (B o-> (A B) A)
-            return IsosurfaceExtraction::Intersection::Continue;
-          }
-          else if (insideA == false && insideB == false)
-          {
-            if (aBeforeB)
-            {
-              // o-> (A (B B) A)
-              // o-> (A (B A) B)
-              // o-> (A A) (B B)
-              return IsosurfaceExtraction::Intersection::Sample;
-            }
-            else
-            {
-              // o-> (B (A A) B)
-              // o-> (B (A B) A)
-              // o-> (B B) (A A)
-              return IsosurfaceExtraction::Intersection::Continue;
-            }
-          }
-          DILAY_IMPOSSIBLE
-        }
-        else if (intersectsA)
-        {
-          intersection = intersectionA;
-          return IsosurfaceExtraction::Intersection::Sample;
+          crossings (rays[i], intersectionsA[i], intersectionsB[i], this->mode, distances[i]);
         }
-        else if (intersectsB)
-        {
-          intersection = intersectionB;
-          return IsosurfaceExtraction::Intersection::Continue;
-        }
-        else
-        {
-          return IsosurfaceExtraction::Intersection::None;
-        }
-        DILAY_IMPOSSIBLE
       };
 
     const IsosurfaceExtraction::DistanceCallback getDistance = [&meshA,
@@ -311,16 +236,8 @@ struct ToolRemesh::Impl
     const PrimAABox bounds (min, max);
 
     DynamicMesh extractedMesh;
-    if (this->mode == Mode::Difference)
-    {
-      IsosurfaceExtraction::extract (getDistance, getDifferenceIntersection, bounds,
-                                     this->resolution, extractedMesh);
-    }
-    else
-    {
-      IsosurfaceExtraction::extract (getDistance, getCommutativeIntersection, bounds,
-                                     this->resolution, extractedMesh);
-    }
+    IsosurfaceExtraction::extract (getDistance, getIntersections, bounds, this->resolution,
+                                   extractedMesh);
 
     State& state = this->self->state ();
     state.scene ().deleteMesh (meshA);
@@ -5,6 +5,7 @@
 #include <QCheckBox>
 #include <QFrame>
 #include <QWheelEvent>
+#include <vector>
 #include "cache.hpp"
 #include "camera.hpp"
 #include "config.hpp"
@@ -13,6 +14,7 @@
 #include "history.hpp"
 #include "maybe.hpp"
 #include "mirror.hpp"
+#include "primitive/plane.hpp"
 #include "primitive/ray.hpp"
 #include "scene.hpp"
 #include "state.hpp"
@@ -197,19 +199,20 @@ struct ToolSculpt::Impl
       {
         this->runCommit ();
       }
+      return ToolResponse::Redraw;
     }
     else
     {
+      // without a pressed button sculpt tools only move their cursor
       this->self->runSculptPointingEvent (e);
+      return ToolResponse::RedrawOverlay;
     }
-    return ToolResponse::Redraw;
   }
 
   ToolResponse runCursorUpdate (const glm::ivec2& pos)
   {
-    DynamicMeshIntersection cursorIntersection;
-    this->setCursorByIntersection (pos, cursorIntersection);
-    return ToolResponse::Redraw;
+    this->setCursorByPicking (pos);
+    return ToolResponse::RedrawOverlay;
   }
 
   ToolResponse runCommit ()
@@ -269,6 +272,45 @@ struct ToolSculpt::Impl
     }
   }
 
+  // sculpts the dabs of a stroke segment on the brush's mesh, see `ToolSculptAction::sculpt`
+  void sculpt (const std::vector<ToolSculptAction::Dab>& dabs)
+  {
+    assert (this->brush.hasPointOfAction ());
+
+    if (dabs.empty ())
+    {
+      return;
+    }
+
+    const glm::vec3 position = this->brush.position ();
+    const glm::vec3 normal = this->brush.normal ();
+
+    ToolSculptAction::sculpt (this->brush, dabs);
+    if (this->self->mirrorEnabled () && this->brush.mesh ().isEmpty () == false)
+    {
+      const PrimPlane& plane = this->self->mirror ().plane ();
+
+      std::vector<ToolSculptAction::Dab> mirrored;
+      mirrored.reserve (dabs.size ());
+      for (const ToolSculptAction::Dab& dab : dabs)
+      {
+        mirrored.push_back ({plane.mirror (dab.position), plane.mirrorDirection (dab.normal)});
+      }
+
+      this->brush.mirror (plane);
+      this->brush.setPointOfAction (this->brush.mesh (), plane.mirror (position),
+                                    plane.mirrorDirection (normal));
+      ToolSculptAction::sculpt (this->brush, mirrored);
+      this->brush.mirror (plane);
+    }
+
+    if (this->brush.mesh ().isEmpty ())
+    {
+      this->self->state ().scene ().deleteEmptyMeshes ();
+      this->brush.resetPointOfAction ();
+    }
+  }
+
   bool setCursorByIntersection (const glm::ivec2& pos, DynamicMeshIntersection& intersection)
   {
     if (this->self->intersectsScene (pos, intersection))
@@ -288,7 +330,28 @@ struct ToolSculpt::Impl
     }
   }
 
-  bool updateBrushByIntersection (bool useRecentMesh, const glm::vec3& cursorStep)
+  // hovering only moves the cursor, dabs are always placed by intersecting the scene
+  void setCursorByPicking (const glm::ivec2& pos)
+  {
+    glm::vec3 position;
+    if (this->self->pickScene (pos, position))
+    {
+      this->cursor.enable ();
+      this->cursor.position (position);
+
+      if (this->absoluteRadius == false)
+      {
+        this->setRelativeRadius ();
+      }
+    }
+    else
+    {
+      this->cursor.disable ();
+    }
+  }
+
+  bool intersectDab (bool useRecentMesh, const glm::vec3& cursorStep, DynamicMesh*& mesh,
+                     ToolSculptAction::Dab& dab)
   {
     const glm::vec3 from = this->self->state ().camera ().position ();
     const PrimRay   ray = PrimRay (from, cursorStep - from);
@@ -297,31 +360,47 @@ struct ToolSculpt::Impl
 
     if (this->self->intersectsScene (ray, intersection))
     {
-      if (this->brush.hasPointOfAction () && (&this->brush.mesh () != &intersection.mesh ()))
-      {
-        this->brush.mesh ().bufferData ();
-      }
+      mesh = &intersection.mesh ();
 
       if (useRecentMesh)
       {
         Intersection rIntersection;
         if (this->self->intersectsRecentDynamicMesh (ray, rIntersection))
         {
-          this->brush.setPointOfAction (intersection.mesh (), rIntersection.position (),
-                                        rIntersection.normal ());
+          dab.position = rIntersection.position ();
+          dab.normal = rIntersection.normal ();
+          return true;
         }
         else
         {
-          this->brush.mesh ().bufferData ();
-          this->brush.resetPointOfAction ();
           return false;
         }
       }
       else
       {
-        this->brush.setPointOfAction (intersection.mesh (), intersection.position (),
-                                      intersection.normal ());
+        dab.position = intersection.position ();
+        dab.normal = intersection.normal ();
+        return true;
+      }
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  bool updateBrushByIntersection (bool useRecentMesh, const glm::vec3& cursorStep)
+  {
+    DynamicMesh*          mesh = nullptr;
+    ToolSculptAction::Dab dab;
+
+    if (this->intersectDab (useRecentMesh, cursorStep, mesh, dab))
+    {
+      if (this->brush.hasPointOfAction () && (&this->brush.mesh () != mesh))
+      {
+        this->brush.mesh ().bufferData ();
       }
+      this->brush.setPointOfAction (*mesh, dab.position, dab.normal);
       return true;
     }
     else
@@ -337,7 +416,12 @@ struct ToolSculpt::Impl
   {
     DynamicMeshIntersection cursorIntersection;
 
-    if (this->setCursorByIntersection (e.position (), cursorIntersection) && e.leftButton ())
+    if (e.leftButton () == false)
+    {
+      this->setCursorByPicking (e.position ());
+      return false;
+    }
+    else if (this->setCursorByIntersection (e.position (), cursorIntersection))
     {
       SBParameters& parameters = this->brush.parameters<SBParameters> ();
       const float   defaultIntesity = parameters.intensity ();
@@ -352,23 +436,49 @@ struct ToolSculpt::Impl
 
       if (this->brush.hasPointOfAction ())
       {
+        // dabs on the brush's mesh are collected and sculpted at once, a dab that leaves the mesh
+        // interrupts the collection and is handled on its own
+        std::vector<ToolSculptAction::Dab> dabs;
+
         this->step.stepWidth (this->brush.stepWidth ());
         this->step.position (this->brush.position ());
-        this->step.step (cursorIntersection.position (),
-                         [this, useRecentMesh](const glm::vec3& brushStep) {
-                           if (this->brush.hasPointOfAction ())
-                           {
-                             if (this->updateBrushByIntersection (useRecentMesh, brushStep))
+
+        while (this->brush.hasPointOfAction ())
+        {
+          bool interrupted = false;
+
+          dabs.clear ();
+          this->step.step (cursorIntersection.position (),
+                           [this, useRecentMesh, &dabs, &interrupted](const glm::vec3& brushStep) {
+                             DynamicMesh*          mesh = nullptr;
+                             ToolSculptAction::Dab dab;
+
+                             if (this->intersectDab (useRecentMesh, brushStep, mesh, dab) &&
+                                 mesh == &this->brush.mesh ())
+                             {
+                               dabs.push_back (dab);
+                               return true;
+                             }
+                             else
                              {
-                               this->sculpt ();
+                               interrupted = true;
+                               return false;
                              }
-                             return true;
-                           }
-                           else
-                           {
-                             return false;
-                           }
-                         });
+                           });
+          this->sculpt (dabs);
+
+          if (interrupted && this->brush.hasPointOfAction ())
+          {
+            if (this->updateBrushByIntersection (useRecentMesh, this->step.position ()))
+            {
+              this->sculpt ();
+            }
+          }
+          else
+          {
+            break;
+          }
+        }
       }
       else
       {
@@ -430,7 +540,7 @@ struct ToolSculpt::Impl
     {
       if (e.leftButton () == false)
       {
-        this->setCursorByIntersection (e.position (), cursorIntersection);
+        this->setCursorByPicking (e.position ());
         return false;
       }
       else if (this->brush.hasPointOfAction ())
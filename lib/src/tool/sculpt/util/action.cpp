@@ -2,12 +2,20 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <functional>
 #include <glm/glm.hpp>
 #include <glm/gtx/norm.hpp>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "dynamic/faces.hpp"
 #include "dynamic/mesh.hpp"
 #include "intersection.hpp"
+#include "mesh.hpp"
 #include "primitive/sphere.hpp"
 #include "primitive/triangle.hpp"
 #include "tool/sculpt/util/action.hpp"
@@ -19,6 +27,21 @@ namespace
 {
   constexpr float minEdgeLength = 0.001f;
 
+  // tables that are reused by all sculpt actions of a thread, such that their storage is allocated
+  // once instead of for every stroke or dab. Each user resets a table before using it.
+  struct Scratch
+  {
+    ToolSculptEdgeMap         newEdges;
+    ToolSculptEdgeSet         edges;
+    std::vector<unsigned int> numSuccessors;  // per vertex, zero outside of `collapseEdge`
+  };
+
+  Scratch& threadScratch ()
+  {
+    static thread_local Scratch scratch;
+    return scratch;
+  }
+
   struct NewFaces
   {
     std::vector<unsigned int>        vertexIndices;
@@ -39,49 +62,69 @@ namespace
 
     void deleteFace (unsigned int i) { this->facesToDelete.insert (i); }
 
+    // deletes faces before adding new ones, which reuse the indices of the deleted faces in reverse
+    // order. A reused index is replaced, such that its face is not deleted from and added to the
+    // octree again.
     bool applyToMesh (DynamicMesh& mesh, DynamicFaces& faces) const
     {
       assert (this->vertexIndices.size () % 3 == 0);
 
-      for (unsigned int i : this->facesToDelete)
+      const std::vector<unsigned int> deleted (this->facesToDelete.begin (),
+                                               this->facesToDelete.end ());
+      const unsigned int numDeleted = deleted.size ();
+      const unsigned int numAdded = this->vertexIndices.size () / 3;
+      const unsigned int numReplaced = std::min (numDeleted, numAdded);
+
+      for (unsigned int i = 0; i < numReplaced; i++)
       {
-        mesh.deleteFace (i);
+        mesh.replaceFace (deleted[numDeleted - 1 - i], this->vertexIndices[(3 * i) + 0],
+                          this->vertexIndices[(3 * i) + 1], this->vertexIndices[(3 * i) + 2]);
       }
 
-      for (unsigned int i = 0; i < this->vertexIndices.size (); i += 3)
+      for (unsigned int i = numReplaced; i < numDeleted; i++)
       {
-        const unsigned int f = mesh.addFace (this->vertexIndices[i + 0], this->vertexIndices[i + 1],
-                                             this->vertexIndices[i + 2]);
+        mesh.deleteFace (deleted[i - numReplaced]);
+      }
 
-        if (i >= this->facesToDelete.size () * 3)
-        {
-          faces.insert (f);
-        }
+      for (unsigned int i = numReplaced; i < numAdded; i++)
+      {
+        faces.insert (mesh.addFace (this->vertexIndices[(3 * i) + 0],
+                                    this->vertexIndices[(3 * i) + 1],
+                                    this->vertexIndices[(3 * i) + 2]));
       }
-      return this->facesToDelete.size () <= (this->vertexIndices.size () / 3);
+      return numDeleted <= numAdded;
     }
   };
 
-  void extendAndFilterDomain (const SculptBrush& brush, DynamicFaces& faces, unsigned int numRings)
+  // keeps the faces that intersect any of the spheres, and extends them by `numRings` rings of
+  // faces around those that are not contained in any of the spheres
+  void extendAndFilterDomain (const DynamicMesh& mesh, const std::vector<PrimSphere>& spheres,
+                              DynamicFaces& faces, unsigned int numRings)
   {
     assert (faces.hasUncomitted () == false);
-    const DynamicMesh& mesh = brush.mesh ();
-    const PrimSphere   sphere = brush.sphere ();
 
     std::unordered_set<unsigned int> frontier;
 
-    faces.filter ([&mesh, &sphere, &frontier](unsigned int i) {
+    faces.filter ([&mesh, &spheres, &frontier](unsigned int i) {
       const PrimTriangle face = mesh.face (i);
+      bool               intersects = false;
 
-      if (IntersectionUtil::intersects (sphere, face) == false)
+      for (const PrimSphere& sphere : spheres)
       {
-        return false;
+        if (IntersectionUtil::intersects (sphere, face))
+        {
+          if (sphere.contains (face))
+          {
+            return true;
+          }
+          intersects = true;
+        }
       }
-      else if (sphere.contains (face) == false)
+      if (intersects)
       {
         frontier.insert (i);
       }
-      return true;
+      return intersects;
     });
 
     for (unsigned int ring = 0; ring < numRings; ring++)
@@ -326,26 +369,42 @@ namespace
     faces.commit ();
   }
 
-  void relaxEdges (DynamicMesh& mesh, const DynamicFaces& faces)
+  bool isRelaxable (const DynamicMesh& mesh, const ui_pair& edge, unsigned int leftVertex,
+                    unsigned int rightVertex)
   {
-    assert (faces.hasUncomitted () == false);
+    const int vE1 = int(mesh.valence (edge.first));
+    const int vE2 = int(mesh.valence (edge.second));
+    const int vL = int(mesh.valence (leftVertex));
+    const int vR = int(mesh.valence (rightVertex));
+
+    const int pre =
+      glm::abs (vE1 - 6) + glm::abs (vE2 - 6) + glm::abs (vL - 6) + glm::abs (vR - 6);
+    const int post = glm::abs (vE1 - 6 - 1) + glm::abs (vE2 - 6 - 1) + glm::abs (vL - 6 + 1) +
+                     glm::abs (vR - 6 + 1);
 
-    const auto isRelaxable = [&mesh](const ui_pair& edge, unsigned int leftVertex,
-                                     unsigned int rightVertex) {
-      const int vE1 = int(mesh.valence (edge.first));
-      const int vE2 = int(mesh.valence (edge.second));
-      const int vL = int(mesh.valence (leftVertex));
-      const int vR = int(mesh.valence (rightVertex));
+    return (vE1 > 3) && (vE2 > 3) && (post < pre);
+  }
 
-      const int pre =
-        glm::abs (vE1 - 6) + glm::abs (vE2 - 6) + glm::abs (vL - 6) + glm::abs (vR - 6);
-      const int post = glm::abs (vE1 - 6 - 1) + glm::abs (vE2 - 6 - 1) + glm::abs (vL - 6 + 1) +
-                       glm::abs (vR - 6 + 1);
+  void relaxEdge (DynamicMesh& mesh, const ui_pair& edge, unsigned int leftFace,
+                  unsigned int leftVertex, unsigned int rightFace, unsigned int rightVertex)
+  {
+    mesh.deleteFace (leftFace);
+    mesh.deleteFace (rightFace);
 
-      return (vE1 > 3) && (vE2 > 3) && (post < pre);
-    };
+    const unsigned int newLeftFace = mesh.addFace (leftVertex, edge.first, rightVertex);
+    const unsigned int newRightFace = mesh.addFace (rightVertex, edge.second, leftVertex);
 
-    ToolSculptEdgeSet edgeSet;
+    assert (newLeftFace == rightFace);
+    assert (newRightFace == leftFace);
+    unused (newLeftFace);
+    unused (newRightFace);
+  }
+
+  void relaxEdges (DynamicMesh& mesh, const DynamicFaces& faces, ToolSculptEdgeSet& edgeSet)
+  {
+    assert (faces.hasUncomitted () == false);
+
+    edgeSet.reset ();
     mesh.forEachVertex (faces, [&mesh, &edgeSet](unsigned int i) {
       if (mesh.valence (i) > 6)
       {
@@ -359,76 +418,66 @@ namespace
       unsigned int leftFace, leftVertex, rightFace, rightVertex;
       mesh.findAdjacent (edge.first, edge.second, leftFace, leftVertex, rightFace, rightVertex);
 
-      if (isRelaxable (edge, leftVertex, rightVertex))
+      if (isRelaxable (mesh, edge, leftVertex, rightVertex))
       {
-        mesh.deleteFace (leftFace);
-        mesh.deleteFace (rightFace);
-
-        const unsigned int newLeftFace = mesh.addFace (leftVertex, edge.first, rightVertex);
-        const unsigned int newRightFace = mesh.addFace (rightVertex, edge.second, leftVertex);
-
-        assert (newLeftFace == rightFace);
-        assert (newRightFace == leftFace);
-        unused (newLeftFace);
-        unused (newRightFace);
+        relaxEdge (mesh, edge, leftFace, leftVertex, rightFace, rightVertex);
       }
     }
   }
 
-  void smooth (DynamicMesh& mesh, DynamicFaces& faces)
+  // only reads the mesh
+  glm::vec3 smoothPosition (const DynamicMesh& mesh, unsigned int i)
   {
-    std::unordered_map<unsigned int, glm::vec3> newPosition;
+    const glm::vec3  avgPos = mesh.averagePosition (i);
+    const glm::vec3& normal = mesh.vertexNormal (i);
+    const glm::vec3  delta = avgPos - mesh.vertex (i);
+    const glm::vec3  tangentialPos = avgPos - (normal * glm::dot (normal, delta));
 
-    mesh.forEachVertex (faces, [&mesh, &newPosition](unsigned int i) {
-      const glm::vec3  avgPos = mesh.averagePosition (i);
-      const glm::vec3& normal = mesh.vertexNormal (i);
-      const glm::vec3  delta = avgPos - mesh.vertex (i);
-      const glm::vec3  tangentialPos = avgPos - (normal * glm::dot (normal, delta));
+    constexpr float lo = -Util::epsilon ();
+    constexpr float hi = 1.0f + Util::epsilon ();
 
-      constexpr float lo = -Util::epsilon ();
-      constexpr float hi = 1.0f + Util::epsilon ();
+    float     minDistance = Util::maxFloat ();
+    glm::vec3 projectedPos (0.0f);
 
-      float     minDistance = Util::maxFloat ();
-      glm::vec3 projectedPos (0.0f);
+    for (unsigned int a : mesh.adjacentFaces (i))
+    {
+      unsigned int i1, i2, i3;
+      mesh.vertexIndices (a, i1, i2, i3);
 
-      for (unsigned int a : mesh.adjacentFaces (i))
-      {
-        unsigned int i1, i2, i3;
-        mesh.vertexIndices (a, i1, i2, i3);
+      const glm::vec3& p1 = mesh.vertex (i1);
+      const glm::vec3& p2 = mesh.vertex (i2);
+      const glm::vec3& p3 = mesh.vertex (i3);
 
-        const glm::vec3& p1 = mesh.vertex (i1);
-        const glm::vec3& p2 = mesh.vertex (i2);
-        const glm::vec3& p3 = mesh.vertex (i3);
+      const glm::vec3 u = p2 - p1;
+      const glm::vec3 v = p3 - p1;
+      const glm::vec3 w = tangentialPos - p1;
+      const glm::vec3 n = glm::cross (u, v);
 
-        const glm::vec3 u = p2 - p1;
-        const glm::vec3 v = p3 - p1;
-        const glm::vec3 w = tangentialPos - p1;
-        const glm::vec3 n = glm::cross (u, v);
+      const float b1 = glm::dot (glm::cross (u, w), n) / (glm::dot (n, n));
+      const float b2 = glm::dot (glm::cross (w, v), n) / (glm::dot (n, n));
+      const float b3 = 1.0f - b1 - b2;
 
-        const float b1 = glm::dot (glm::cross (u, w), n) / (glm::dot (n, n));
-        const float b2 = glm::dot (glm::cross (w, v), n) / (glm::dot (n, n));
-        const float b3 = 1.0f - b1 - b2;
+      if (lo < b1 && b1 < hi && lo < b2 && b2 < hi && lo < b3 && b3 < hi)
+      {
+        const glm::vec3 proj = (b3 * p1) + (b2 * p2) + (b1 * p3);
+        const float     d = glm::distance2 (tangentialPos, proj);
 
-        if (lo < b1 && b1 < hi && lo < b2 && b2 < hi && lo < b3 && b3 < hi)
+        if (d < minDistance)
         {
-          const glm::vec3 proj = (b3 * p1) + (b2 * p2) + (b1 * p3);
-          const float     d = glm::distance2 (tangentialPos, proj);
-
-          if (d < minDistance)
-          {
-            minDistance = d;
-            projectedPos = proj;
-          }
+          minDistance = d;
+          projectedPos = proj;
         }
       }
-      if (minDistance != Util::maxFloat ())
-      {
-        newPosition.emplace (i, projectedPos);
-      }
-      else
-      {
-        newPosition.emplace (i, tangentialPos);
-      }
+    }
+    return minDistance == Util::maxFloat () ? tangentialPos : projectedPos;
+  }
+
+  void smooth (DynamicMesh& mesh, DynamicFaces& faces)
+  {
+    std::unordered_map<unsigned int, glm::vec3> newPosition;
+
+    mesh.forEachVertex (faces, [&mesh, &newPosition](unsigned int i) {
+      newPosition.emplace (i, smoothPosition (mesh, i));
     });
 
     for (const auto& it : newPosition)
@@ -511,7 +560,8 @@ namespace
     }
   };
 
-  bool collapseEdge (DynamicMesh& mesh, unsigned int i1, unsigned int i2, DynamicFaces faces)
+  bool collapseEdge (DynamicMesh& mesh, unsigned int i1, unsigned int i2, DynamicFaces& faces,
+                     Scratch& scratch)
   {
     const unsigned int v1 = mesh.valence (i1);
     const unsigned int v2 = mesh.valence (i2);
@@ -571,7 +621,9 @@ namespace
       }
     };
 
-    const auto numCommonAdjacentVertices = [&mesh, &i1, &i2]() -> unsigned int {
+    // marks the successors of `i1` in a per-vertex table, such that the link condition is checked
+    // in O(valence)
+    const auto numCommonAdjacentVertices = [&mesh, &scratch, i1, i2]() -> unsigned int {
       const auto getSuccessor = [&mesh](unsigned int i, unsigned int a) {
         unsigned int a1, a2, a3;
         mesh.vertexIndices (a, a1, a2, a3);
@@ -594,22 +646,33 @@ namespace
         }
       };
 
-      unsigned int n = 0;
+      std::vector<unsigned int>& numSuccessors = scratch.numSuccessors;
+
+      if (numSuccessors.size () < mesh.mesh ().numVertices ())
+      {
+        numSuccessors.resize (mesh.mesh ().numVertices (), 0);
+      }
+
       for (unsigned int a1 : mesh.adjacentFaces (i1))
       {
         const unsigned int succI1 = getSuccessor (i1, a1);
 
         if (succI1 != i2)
         {
-          for (unsigned int a2 : mesh.adjacentFaces (i2))
-          {
-            if (succI1 == getSuccessor (i2, a2))
-            {
-              n++;
-            }
-          }
+          numSuccessors[succI1]++;
         }
       }
+
+      unsigned int n = 0;
+      for (unsigned int a2 : mesh.adjacentFaces (i2))
+      {
+        n += numSuccessors[getSuccessor (i2, a2)];
+      }
+
+      for (unsigned int a1 : mesh.adjacentFaces (i1))
+      {
+        numSuccessors[getSuccessor (i1, a1)] = 0;
+      }
       return n;
     };
 
@@ -685,46 +748,44 @@ namespace
   }
 
   typedef std::function<bool(unsigned int, unsigned int)> CollapsePredicate;
-  bool collapseEdges (DynamicMesh& mesh, const CollapsePredicate& doCollapse, DynamicFaces& faces)
+
+  // visits each face of `faces` once and collapses its first collapsible edge. Faces that are added
+  // by a collapse are not visited, unless they reuse the index of a face that is yet to be visited.
+  bool collapseEdges (DynamicMesh& mesh, const CollapsePredicate& doCollapse, DynamicFaces& faces,
+                      Scratch& scratch)
   {
     bool         collapsed = false;
-    DynamicFaces current;
-    current.insert (faces.indices ());
+    DynamicFaces discarded;
 
-    do
+    for (unsigned int i : faces)
     {
-      faces.insert (current.uncommitted ());
-      current.commit ();
-
-      for (unsigned int i : current)
+      if (mesh.isFreeFace (i) == false)
       {
-        if (mesh.isFreeFace (i) == false)
-        {
-          unsigned int i1, i2, i3;
-          mesh.vertexIndices (i, i1, i2, i3);
+        unsigned int i1, i2, i3;
+        mesh.vertexIndices (i, i1, i2, i3);
 
-          if (doCollapse (i1, i2))
-          {
-            collapsed = collapseEdge (mesh, i1, i2, current) || collapsed;
-          }
-          else if (doCollapse (i1, i3))
-          {
-            collapsed = collapseEdge (mesh, i1, i3, current) || collapsed;
-          }
-          else if (doCollapse (i2, i3))
-          {
-            collapsed = collapseEdge (mesh, i2, i3, current) || collapsed;
-          }
+        if (doCollapse (i1, i2))
+        {
+          collapsed = collapseEdge (mesh, i1, i2, discarded, scratch) || collapsed;
+        }
+        else if (doCollapse (i1, i3))
+        {
+          collapsed = collapseEdge (mesh, i1, i3, discarded, scratch) || collapsed;
+        }
+        else if (doCollapse (i2, i3))
+        {
+          collapsed = collapseEdge (mesh, i2, i3, discarded, scratch) || collapsed;
         }
       }
-    } while (current.uncommitted ().empty () == false);
+    }
 
     faces.filter ([&mesh](unsigned int f) { return mesh.isFreeFace (f) == false; });
     faces.commit ();
     return collapsed;
   }
 
-  bool collapseEdgesByLength (DynamicMesh& mesh, float maxEdgeLengthSqr, DynamicFaces& faces)
+  bool collapseEdgesByLength (DynamicMesh& mesh, float maxEdgeLengthSqr, DynamicFaces& faces,
+                              Scratch& scratch)
   {
     const auto isCollapsable = [&mesh, maxEdgeLengthSqr](unsigned int i1, unsigned i2) -> bool {
       assert (mesh.isFreeVertex (i1) == false);
@@ -732,21 +793,232 @@ namespace
 
       return glm::distance2 (mesh.vertex (i1), mesh.vertex (i2)) < maxEdgeLengthSqr;
     };
-    return collapseEdges (mesh, isCollapsable, faces);
+    return collapseEdges (mesh, isCollapsable, faces, scratch);
+  }
+
+  bool collapseAllEdges (DynamicMesh& mesh, DynamicFaces& faces, Scratch& scratch)
+  {
+    return collapseEdges (mesh, [](unsigned int, unsigned int) { return true; }, faces, scratch);
   }
 
-  bool collapseAllEdges (DynamicMesh& mesh, DynamicFaces& faces)
+  // subdivides `faces` in rounds until no edge within any of the spheres is longer than the brush's
+  // subdivision threshold
+  void subdivide (const SculptBrush& brush, const std::vector<PrimSphere>& spheres,
+                  DynamicFaces& faces, Scratch& scratch)
   {
-    return collapseEdges (mesh, [](unsigned int, unsigned int) { return true; }, faces);
+    DynamicMesh&       mesh = brush.mesh ();
+    ToolSculptEdgeMap& newEdges = scratch.newEdges;
+
+    // after the first round, only faces created by the previous round and their one-ring are
+    // examined, and the octree is realigned once for all subdivided faces
+    DynamicFaces subdivided;
+    unsigned int numRings = 1;
+    do
+    {
+      newEdges.reset ();
+
+      extendAndFilterDomain (mesh, spheres, faces, numRings);
+      extendDomainByPoles (mesh, faces);
+
+      const float maxLength = glm::max (brush.subdivThreshold (), 2.0f * minEdgeLength);
+      splitEdges (mesh, newEdges, maxLength, faces);
+
+      if (newEdges.isEmpty () == false)
+      {
+        triangulate (mesh, newEdges, faces);
+        extendDomain (mesh, faces, 1);
+        relaxEdges (mesh, faces, scratch.edges);
+        smooth (mesh, faces);
+        mesh.forEachVertex (faces, [&mesh](unsigned int i) { mesh.setVertexNormal (i); });
+
+        subdivided.insert (faces.indices ());
+        subdivided.commit ();
+        numRings = 0;
+      }
+    } while (faces.numElements () > 0 && newEdges.isEmpty () == false);
+
+    if (subdivided.isEmpty () == false)
+    {
+      subdivided.filter ([&mesh](unsigned int f) { return mesh.isFreeFace (f) == false; });
+      mesh.realignFaces (subdivided);
+    }
   }
 
   void finalize (DynamicMesh& mesh, const DynamicFaces& faces)
   {
     mesh.forEachVertex (faces, [&mesh](unsigned int i) { mesh.setVertexNormal (i); });
+    mesh.realignFaces (faces);
+  }
 
-    for (unsigned int i : faces)
+  // calls `f (begin, end)` for consecutive ranges of [0, n), one range per core
+  void inParallel (unsigned int n, const std::function<void(unsigned int, unsigned int)>& f)
+  {
+    const unsigned int numThreads = std::max (1u, std::thread::hardware_concurrency ());
+    const unsigned int rangeSize = (n + numThreads - 1) / numThreads;
+
+    if (numThreads == 1 || n < numThreads)
+    {
+      f (0, n);
+    }
+    else
+    {
+      std::vector<std::thread> threads;
+
+      for (unsigned int t = 1; t < numThreads; t++)
+      {
+        threads.emplace_back (f, std::min (n, t * rangeSize), std::min (n, (t + 1) * rangeSize));
+      }
+      f (0, rangeSize);
+
+      for (std::thread& thread : threads)
+      {
+        thread.join ();
+      }
+    }
+  }
+
+  /* Relaxes the edges of all vertices with a valence greater than 6.
+   * Pending edges are evaluated in parallel, since this only reads the mesh.
+   * Afterwards, the relaxable edges are flipped in order, unless an edge shares a vertex with an
+   * edge that has already been flipped in the same round. Such an edge is deferred to the next
+   * round, because its evaluation is outdated.
+   * Flipping itself is sequential, since it updates the mesh's octree and buffers.
+   */
+  void relaxAllEdges (DynamicMesh& mesh)
+  {
+    struct Edge
+    {
+      ui_pair      edge;
+      unsigned int leftFace, leftVertex, rightFace, rightVertex;
+      bool         isRelaxable;
+    };
+
+    const unsigned int        numVertices = mesh.mesh ().numVertices ();
+    std::vector<Edge>         pending;
+    std::vector<Edge>         deferred;
+    std::vector<unsigned int> flippedInRound (numVertices, Util::invalidIndex ());
+
+    const auto isCandidate = [&mesh](unsigned int i) {
+      return mesh.isFreeVertex (i) == false && mesh.valence (i) > 6;
+    };
+
+    for (unsigned int i = 0; i < numVertices; i++)
+    {
+      if (isCandidate (i))
+      {
+        mesh.forEachVertexAdjacentToVertex (i, [i, &pending, &isCandidate](unsigned int j) {
+          // an edge between two candidates is collected at its smaller vertex index only
+          if (i < j || isCandidate (j) == false)
+          {
+            pending.push_back ({ui_pair (i, j), 0, 0, 0, 0, false});
+          }
+        });
+      }
+    }
+
+    for (unsigned int round = 0; pending.empty () == false; round++)
+    {
+      inParallel (pending.size (), [&mesh, &pending](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++)
+        {
+          Edge& e = pending[i];
+
+          mesh.findAdjacent (e.edge.first, e.edge.second, e.leftFace, e.leftVertex, e.rightFace,
+                             e.rightVertex);
+          e.isRelaxable = isRelaxable (mesh, e.edge, e.leftVertex, e.rightVertex);
+        }
+      });
+
+      deferred.clear ();
+      for (const Edge& e : pending)
+      {
+        const std::array<unsigned int, 4> vertices = {e.edge.first, e.edge.second, e.leftVertex,
+                                                      e.rightVertex};
+
+        if (std::any_of (vertices.begin (), vertices.end (),
+                         [&flippedInRound, round](unsigned int v) {
+                           return flippedInRound[v] == round;
+                         }))
+        {
+          deferred.push_back (e);
+        }
+        else if (e.isRelaxable)
+        {
+          for (unsigned int v : vertices)
+          {
+            flippedInRound[v] = round;
+          }
+          relaxEdge (mesh, e.edge, e.leftFace, e.leftVertex, e.rightFace, e.rightVertex);
+        }
+      }
+      std::swap (pending, deferred);
+    }
+  }
+
+  // Jacobi-style smoothing of all vertices: new positions are computed in parallel from the old
+  // positions and applied afterwards
+  void smoothAllVertices (DynamicMesh& mesh)
+  {
+    const unsigned int         numVertices = mesh.mesh ().numVertices ();
+    std::vector<glm::vec3>     newPositions (numVertices);
+    std::vector<unsigned char> isSmoothed (numVertices, 0);
+
+    inParallel (numVertices,
+                [&mesh, &newPositions, &isSmoothed](unsigned int begin, unsigned int end) {
+                  for (unsigned int i = begin; i < end; i++)
+                  {
+                    if (mesh.isFreeVertex (i) == false)
+                    {
+                      newPositions[i] = smoothPosition (mesh, i);
+                      isSmoothed[i] = 1;
+                    }
+                  }
+                });
+
+    for (unsigned int i = 0; i < numVertices; i++)
+    {
+      if (isSmoothed[i])
+      {
+        mesh.vertex (i, newPositions[i]);
+      }
+    }
+  }
+
+  void setAllNormals (DynamicMesh& mesh)
+  {
+    const unsigned int     numFaces = mesh.mesh ().numIndices () / 3;
+    const unsigned int     numVertices = mesh.mesh ().numVertices ();
+    std::vector<glm::vec3> normals (numVertices);
+
+    // updates the cached normal of each face in exactly one thread, such that computing the
+    // vertex normals afterwards only reads the mesh
+    inParallel (numFaces, [&mesh](unsigned int begin, unsigned int end) {
+      for (unsigned int i = begin; i < end; i++)
+      {
+        if (mesh.isFreeFace (i) == false)
+        {
+          mesh.faceArea (i);
+        }
+      }
+    });
+
+    inParallel (numVertices, [&mesh, &normals](unsigned int begin, unsigned int end) {
+      for (unsigned int i = begin; i < end; i++)
+      {
+        if (mesh.isFreeVertex (i) == false)
+        {
+          const glm::vec3 normal = mesh.averageNormal (i);
+          normals[i] = Util::isNaN (normal) ? glm::vec3 (0.0f) : normal;
+        }
+      }
+    });
+
+    for (unsigned int i = 0; i < numVertices; i++)
     {
-      mesh.realignFace (i);
+      if (mesh.isFreeVertex (i) == false)
+      {
+        mesh.vertexNormal (i, normals[i]);
+      }
     }
   }
 }
@@ -760,12 +1032,13 @@ namespace ToolSculptAction
     if (faces.numElements () > 0)
     {
       DynamicMesh& mesh = brush.mesh ();
+      Scratch&     scratch = threadScratch ();
 
       if (brush.parameters ().reduce ())
       {
         const float maxEdgeLengthSqr =
           mesh.averageEdgeLengthSqr (faces) * brush.parameters ().intensity ();
-        collapseEdgesByLength (mesh, maxEdgeLengthSqr, faces);
+        collapseEdgesByLength (mesh, maxEdgeLengthSqr, faces, scratch);
 
         if (mesh.isEmpty ())
         {
@@ -784,32 +1057,76 @@ namespace ToolSculptAction
       {
         if (brush.subdivide ())
         {
-          ToolSculptEdgeMap newEdges;
-          do
-          {
-            newEdges.reset ();
+          subdivide (brush, {brush.sphere ()}, faces, scratch);
+        }
+        faces = brush.getAffectedFaces ();
+        brush.sculpt (faces);
+        collapseEdgesByLength (mesh, minEdgeLength * minEdgeLength, faces, scratch);
+        finalize (mesh, faces);
+      }
+    }
+  }
 
-            extendAndFilterDomain (brush, faces, 1);
-            extendDomainByPoles (mesh, faces);
+  void sculpt (SculptBrush& brush, const std::vector<Dab>& dabs)
+  {
+    assert (brush.hasPointOfAction ());
 
-            const float maxLength = glm::max (brush.subdivThreshold (), 2.0f * minEdgeLength);
-            splitEdges (mesh, newEdges, maxLength, faces);
+    DynamicMesh& mesh = brush.mesh ();
 
-            if (newEdges.isEmpty () == false)
-            {
-              triangulate (mesh, newEdges, faces);
-            }
-            extendDomain (mesh, faces, 1);
-            relaxEdges (mesh, faces);
-            smooth (mesh, faces);
-            finalize (mesh, faces);
-          } while (faces.numElements () > 0 && newEdges.isEmpty () == false);
+    if (brush.parameters ().reduce ())
+    {
+      for (const Dab& dab : dabs)
+      {
+        brush.setPointOfAction (mesh, dab.position, dab.normal);
+        sculpt (brush);
+
+        if (mesh.isEmpty ())
+        {
+          return;
         }
+      }
+    }
+    else
+    {
+      const glm::vec3 position = brush.position ();
+      const glm::vec3 normal = brush.normal ();
+
+      std::vector<PrimSphere> spheres;
+      DynamicFaces            faces;
+      Scratch&                scratch = threadScratch ();
+
+      spheres.reserve (dabs.size ());
+      for (const Dab& dab : dabs)
+      {
+        brush.setPointOfAction (mesh, dab.position, dab.normal);
+        spheres.push_back (brush.sphere ());
+        faces.insert (brush.getAffectedFaces ().indices ());
+      }
+      faces.commit ();
+
+      if (faces.numElements () > 0 && brush.subdivide ())
+      {
+        subdivide (brush, spheres, faces, scratch);
+      }
+
+      // restores the brush's position, so that the first dab's last position is the one before
+      // this stroke segment
+      brush.setPointOfAction (mesh, position, normal);
+
+      DynamicFaces sculpted;
+      for (const Dab& dab : dabs)
+      {
+        brush.setPointOfAction (mesh, dab.position, dab.normal);
+
         faces = brush.getAffectedFaces ();
         brush.sculpt (faces);
-        collapseEdgesByLength (mesh, minEdgeLength * minEdgeLength, faces);
-        finalize (mesh, faces);
+        mesh.realignFaces (faces);
+
+        sculpted.insert (faces.indices ());
+        sculpted.commit ();
       }
+      collapseEdgesByLength (mesh, minEdgeLength * minEdgeLength, sculpted, scratch);
+      finalize (mesh, sculpted);
     }
   }
 
@@ -817,20 +1134,72 @@ namespace ToolSculptAction
   {
     DynamicFaces faces;
 
+    relaxAllEdges (mesh);
+    smoothAllVertices (mesh);
+    setAllNormals (mesh);
+
     mesh.forEachFace ([&faces](unsigned int i) { faces.insert (i); });
     faces.commit ();
-    relaxEdges (mesh, faces);
-    smooth (mesh, faces);
-    finalize (mesh, faces);
+    mesh.realignFaces (faces);
     mesh.bufferData ();
   }
 
   bool deleteFaces (DynamicMesh& mesh, DynamicFaces& faces)
   {
-    bool collapsed = collapseAllEdges (mesh, faces);
-    collapsed = collapseEdgesByLength (mesh, minEdgeLength * minEdgeLength, faces) || collapsed;
+    Scratch& scratch = threadScratch ();
+    bool     collapsed = collapseAllEdges (mesh, faces, scratch);
+
+    collapsed =
+      collapseEdgesByLength (mesh, minEdgeLength * minEdgeLength, faces, scratch) || collapsed;
     finalize (mesh, faces);
     mesh.bufferData ();
     return collapsed;
   }
+
+  // collapses edges shorter than `maxEdgeLength` in a single pass over all faces of the mesh
+  // without buffering it, i.e. this may be called from a background thread on a private mesh.
+  // The pass stops early once `isCancelled` is set, leaving the mesh valid but without normals.
+  bool reduceMesh (DynamicMesh& mesh, float maxEdgeLength, const std::atomic<bool>& isCancelled)
+  {
+    const float        maxEdgeLengthSqr = maxEdgeLength * maxEdgeLength;
+    const unsigned int numFaces = mesh.mesh ().numIndices () / 3;
+    bool               collapsed = false;
+    DynamicFaces       discarded;
+    Scratch&           scratch = threadScratch ();
+
+    const auto isCollapsable = [&mesh, maxEdgeLengthSqr](unsigned int i1, unsigned i2) -> bool {
+      return glm::distance2 (mesh.vertex (i1), mesh.vertex (i2)) < maxEdgeLengthSqr;
+    };
+
+    for (unsigned int i = 0; i < numFaces; i++)
+    {
+      if (i % 1024 == 0 && isCancelled)
+      {
+        return false;
+      }
+      else if (mesh.isFreeFace (i) == false)
+      {
+        unsigned int i1, i2, i3;
+        mesh.vertexIndices (i, i1, i2, i3);
+
+        if (isCollapsable (i1, i2))
+        {
+          collapsed = collapseEdge (mesh, i1, i2, discarded, scratch) || collapsed;
+        }
+        else if (isCollapsable (i1, i3))
+        {
+          collapsed = collapseEdge (mesh, i1, i3, discarded, scratch) || collapsed;
+        }
+        else if (isCollapsable (i2, i3))
+        {
+          collapsed = collapseEdge (mesh, i2, i3, discarded, scratch) || collapsed;
+        }
+      }
+    }
+    if (collapsed)
+    {
+      mesh.setAllNormals ();
+    }
+    return collapsed;
+  }
 }
@@ -5,14 +5,32 @@
 #ifndef DILAY_TOOL_SCULPT_ACTION
 #define DILAY_TOOL_SCULPT_ACTION
 
+#include <atomic>
+#include <glm/glm.hpp>
+#include <vector>
+
+class DynamicFaces;
 class DynamicMesh;
 class SculptBrush;
 
 namespace ToolSculptAction
 {
+  struct Dab
+  {
+    glm::vec3 position;
+    glm::vec3 normal;
+  };
+
   void sculpt (const SculptBrush&);
+
+  /* Sculpts a sequence of dabs of a stroke on the brush's mesh.
+   * The union of the dabs' domains is subdivided once, before their displacements are applied in
+   * order. The brush is left at the last dab.
+   */
+  void sculpt (SculptBrush&, const std::vector<Dab>&);
   void smoothMesh (DynamicMesh&);
   bool deleteFaces (DynamicMesh&, DynamicFaces&);
+  bool reduceMesh (DynamicMesh&, float, const std::atomic<bool>&);
 };
 
 #endif
@@ -4,28 +4,107 @@
  */
 #include <glm/glm.hpp>
 #include "tool/sculpt/util/edge-collection.hpp"
-#include "util.hpp"
 
 namespace
 {
-  ui_pair makeUiKey (unsigned int i1, unsigned int i2)
+  constexpr unsigned int initialNumSlots = 256;
+  constexpr uint64_t     emptyKey = ~uint64_t (0);
+
+  uint64_t makeKey (unsigned int i1, unsigned int i2)
   {
     assert (i1 != i2);
-    return ui_pair (glm::min (i1, i2), glm::max (i1, i2));
+    return (uint64_t (glm::min (i1, i2)) << 32) | uint64_t (glm::max (i1, i2));
+  }
+
+  // Fibonacci hashing: `numSlots` is a power of two
+  unsigned int hashKey (uint64_t key, unsigned int numSlots)
+  {
+    return unsigned ((key * 0x9e3779b97f4a7c15ull) >> 32) & (numSlots - 1);
+  }
+}
+
+ToolSculptEdgeTable::ToolSculptEdgeTable ()
+  : slots (initialNumSlots, Slot{emptyKey, 0})
+{
+}
+
+bool ToolSculptEdgeTable::insert (unsigned int i1, unsigned int i2, unsigned int value)
+{
+  if (2 * (this->occupied.size () + 1) > this->slots.size ())
+  {
+    this->grow ();
+  }
+  const uint64_t     key = makeKey (i1, i2);
+  const unsigned int s = this->findSlot (key);
+
+  if (this->slots[s].key == key)
+  {
+    return false;
+  }
+  else
+  {
+    this->slots[s] = Slot{key, value};
+    this->occupied.push_back (s);
+    return true;
+  }
+}
+
+unsigned int ToolSculptEdgeTable::find (unsigned int i1, unsigned int i2) const
+{
+  const Slot& slot = this->slots[this->findSlot (makeKey (i1, i2))];
+
+  return slot.key == emptyKey ? Util::invalidIndex () : slot.value;
+}
+
+void ToolSculptEdgeTable::reset ()
+{
+  for (unsigned int s : this->occupied)
+  {
+    this->slots[s].key = emptyKey;
+  }
+  this->occupied.clear ();
+}
+
+unsigned int ToolSculptEdgeTable::findSlot (uint64_t key) const
+{
+  const unsigned int numSlots = this->slots.size ();
+
+  for (unsigned int s = hashKey (key, numSlots);; s = (s + 1) & (numSlots - 1))
+  {
+    if (this->slots[s].key == key || this->slots[s].key == emptyKey)
+    {
+      return s;
+    }
+  }
+}
+
+void ToolSculptEdgeTable::grow ()
+{
+  std::vector<Slot> oldSlots (2 * this->slots.size (), Slot{emptyKey, 0});
+  std::vector<unsigned int> oldOccupied;
+
+  this->slots.swap (oldSlots);
+  this->occupied.swap (oldOccupied);
+  this->occupied.reserve (oldOccupied.size ());
+
+  for (unsigned int s : oldOccupied)
+  {
+    const unsigned int newS = this->findSlot (oldSlots[s].key);
+
+    this->slots[newS] = oldSlots[s];
+    this->occupied.push_back (newS);
   }
 }
 
 void ToolSculptEdgeMap::insert (unsigned int i1, unsigned int i2, unsigned int value)
 {
   assert (this->contains (i1, i2) == false);
-  this->map.emplace (makeUiKey (i1, i2), value);
+  this->table.insert (i1, i2, value);
 }
 
 unsigned int ToolSculptEdgeMap::find (unsigned int i1, unsigned int i2) const
 {
-  const auto it = this->map.find (makeUiKey (i1, i2));
-
-  return it == this->map.end () ? Util::invalidIndex () : it->second;
+  return this->table.find (i1, i2);
 }
 
 bool ToolSculptEdgeMap::contains (unsigned int i1, unsigned int i2) const
@@ -33,20 +112,27 @@ bool ToolSculptEdgeMap::contains (unsigned int i1, unsigned int i2) const
   return this->find (i1, i2) != Util::invalidIndex ();
 }
 
-bool ToolSculptEdgeMap::isEmpty () const { return this->map.empty (); }
+bool ToolSculptEdgeMap::isEmpty () const { return this->table.numElements () == 0; }
 
-void ToolSculptEdgeMap::reset () { this->map.clear (); }
+void ToolSculptEdgeMap::reset () { this->table.reset (); }
 
 void ToolSculptEdgeSet::insert (unsigned int i1, unsigned int i2)
 {
-  this->set.emplace (makeUiKey (i1, i2));
+  if (this->table.insert (i1, i2, 0))
+  {
+    this->edges.emplace_back (glm::min (i1, i2), glm::max (i1, i2));
+  }
 }
 
 bool ToolSculptEdgeSet::contains (unsigned int i1, unsigned int i2) const
 {
-  return this->set.find (makeUiKey (i1, i2)) != this->set.end ();
+  return this->table.find (i1, i2) != Util::invalidIndex ();
 }
 
-bool ToolSculptEdgeSet::isEmpty () const { return this->set.empty (); }
+bool ToolSculptEdgeSet::isEmpty () const { return this->edges.empty (); }
 
-void ToolSculptEdgeSet::reset () { this->set.clear (); }
+void ToolSculptEdgeSet::reset ()
+{
+  this->table.reset ();
+  this->edges.clear ();
+}
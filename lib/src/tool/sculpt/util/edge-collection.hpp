@@ -5,15 +5,41 @@
 #ifndef DILAY_TOOL_SCULPT_EDGE_COLLECTION
 #define DILAY_TOOL_SCULPT_EDGE_COLLECTION
 
-#include <unordered_map>
-#include <unordered_set>
-#include "hash.hpp"
+#include <cstdint>
+#include <vector>
+#include "util.hpp"
 
-class ToolSculptEdgeMap
+/* Open-addressing hash table of undirected edges, each mapped to an index.
+ * An edge is keyed by its two vertex indices packed into a 64-bit integer.
+ * `reset` clears occupied slots only and keeps the allocated storage for the next iteration.
+ */
+class ToolSculptEdgeTable
 {
 public:
-  typedef std::unordered_map<std::pair<unsigned int, unsigned int>, unsigned int> Map;
+  ToolSculptEdgeTable ();
+
+  bool         insert (unsigned int, unsigned int, unsigned int);
+  unsigned int find (unsigned int, unsigned int) const;
+  unsigned int numElements () const { return this->occupied.size (); }
+  void         reset ();
+
+private:
+  struct Slot
+  {
+    uint64_t     key;
+    unsigned int value;
+  };
 
+  unsigned int findSlot (uint64_t) const;
+  void         grow ();
+
+  std::vector<Slot>         slots;
+  std::vector<unsigned int> occupied;
+};
+
+class ToolSculptEdgeMap
+{
+public:
   void         insert (unsigned int, unsigned int, unsigned int);
   unsigned int find (unsigned int, unsigned int) const;
   bool         contains (unsigned int, unsigned int) const;
@@ -21,24 +47,25 @@ public:
   void         reset ();
 
 private:
-  Map map;
+  ToolSculptEdgeTable table;
 };
 
 class ToolSculptEdgeSet
 {
 public:
-  typedef std::unordered_set<std::pair<unsigned int, unsigned int>> Set;
+  typedef std::vector<ui_pair> Edges;
 
   void insert (unsigned int, unsigned int);
   bool contains (unsigned int, unsigned int) const;
   bool isEmpty () const;
   void reset ();
 
-  Set::const_iterator begin () const { return this->set.begin (); }
-  Set::const_iterator end () const { return this->set.end (); }
+  Edges::const_iterator begin () const { return this->edges.begin (); }
+  Edges::const_iterator end () const { return this->edges.end (); }
 
 private:
-  Set set;
+  ToolSculptEdgeTable table;
+  Edges               edges;
 };
 
 #endif
@@ -2,12 +2,14 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
 #include <functional>
 #include <glm/glm.hpp>
 #include <glm/gtx/norm.hpp>
 #include <list>
-#include <unordered_set>
+#include <vector>
 #include "dynamic/mesh.hpp"
+#include "mesh.hpp"
 #include "primitive/plane.hpp"
 #include "tool/trim-mesh/action.hpp"
 #include "tool/trim-mesh/border.hpp"
@@ -55,6 +57,23 @@ namespace
       return location (pos, from, to) == Location::Right;
     }
 
+    // contribution of the segment from `from` to `to` to the winding number of `pos`
+    int winding (const glm::vec2& pos, const glm::vec2& from, const glm::vec2& to)
+    {
+      if (from.y <= pos.y && pos.y < to.y && isLeft (pos, from, to))
+      {
+        return 1;
+      }
+      else if (to.y <= pos.y && pos.y < from.y && isRight (pos, from, to))
+      {
+        return -1;
+      }
+      else
+      {
+        return 0;
+      }
+    }
+
     struct TwoDSquare
     {
       enum class State
@@ -179,6 +198,90 @@ namespace
     typedef TwoDVertices::iterator       TwoDVertexRef;
     typedef TwoDVertices::const_iterator TwoDVertexCRef;
 
+    /* Buckets of vertices on a uniform grid over their bounding box.
+     * Ear tests only visit the vertices of the buckets that overlap an ear's bounding box.
+     */
+    struct TwoDVertexBuckets
+    {
+      glm::vec2                               min;
+      glm::vec2                               cellSize;
+      unsigned int                            dimension;
+      std::vector<std::vector<TwoDVertexRef>> buckets;
+
+      TwoDVertexBuckets (TwoDVertices& vertices)
+        : min (Util::maxFloat ())
+      {
+        glm::vec2 max (Util::minFloat ());
+
+        for (const TwoDVertex& v : vertices)
+        {
+          this->min = glm::min (this->min, v.position);
+          max = glm::max (max, v.position);
+        }
+        this->dimension = glm::max (1u, (unsigned int) (glm::sqrt (float(vertices.size ()))));
+        this->cellSize = glm::max ((max - this->min) / float(this->dimension),
+                                   glm::vec2 (Util::epsilon ()));
+        this->buckets.resize (this->dimension * this->dimension);
+
+        for (TwoDVertexRef v = vertices.begin (); v != vertices.end (); ++v)
+        {
+          this->bucket (this->cell (v->position)).push_back (v);
+        }
+      }
+
+      glm::uvec2 cell (const glm::vec2& p) const
+      {
+        const glm::vec2 c = glm::floor ((p - this->min) / this->cellSize);
+        const float     last = float(this->dimension - 1);
+
+        return glm::uvec2 (glm::clamp (c, glm::vec2 (0.0f), glm::vec2 (last)));
+      }
+
+      std::vector<TwoDVertexRef>& bucket (const glm::uvec2& c)
+      {
+        return this->buckets[(c.y * this->dimension) + c.x];
+      }
+
+      void remove (TwoDVertexRef v)
+      {
+        std::vector<TwoDVertexRef>& b = this->bucket (this->cell (v->position));
+
+        for (TwoDVertexRef& r : b)
+        {
+          if (r == v)
+          {
+            r = b.back ();
+            b.pop_back ();
+            return;
+          }
+        }
+        DILAY_IMPOSSIBLE
+      }
+
+      // true if `f` holds for one of the vertices in the box from `boxMin` to `boxMax`
+      template <typename F>
+      bool any (const glm::vec2& boxMin, const glm::vec2& boxMax, const F& f) const
+      {
+        const glm::uvec2 cMin = this->cell (boxMin);
+        const glm::uvec2 cMax = this->cell (boxMax);
+
+        for (unsigned int y = cMin.y; y <= cMax.y; y++)
+        {
+          for (unsigned int x = cMin.x; x <= cMax.x; x++)
+          {
+            for (TwoDVertexCRef v : this->buckets[(y * this->dimension) + x])
+            {
+              if (f (v))
+              {
+                return true;
+              }
+            }
+          }
+        }
+        return false;
+      }
+    };
+
     struct TwoDPolyline;
     typedef std::vector<TwoDPolyline> TwoDPolylines;
 
@@ -237,25 +340,19 @@ namespace
         }
       }
 
-      void setIsEar (TwoDVertexRef v) const
+      void setIsEar (TwoDVertexRef v, const TwoDVertexBuckets& buckets) const
       {
         if (v->curvature == Curvature::Convex)
         {
           const TwoDVertexCRef p = this->prev (v);
           const TwoDVertexCRef n = this->next (v);
+          const glm::vec2      min = glm::min (p->position, glm::min (v->position, n->position));
+          const glm::vec2      max = glm::max (p->position, glm::max (v->position, n->position));
 
-          for (TwoDVertexCRef it = this->begin (); it != this->end (); ++it)
-          {
-            if (it != p && it != v && it != n)
-            {
-              if (it->isInsideTriangle (p->position, v->position, n->position))
-              {
-                v->isEar = false;
-                return;
-              }
-            }
-          }
-          v->isEar = true;
+          v->isEar = buckets.any (min, max, [&p, &v, &n](TwoDVertexCRef it) {
+            return it != p && it != v && it != n &&
+                   it->isInsideTriangle (p->position, v->position, n->position);
+          }) == false;
         }
         else
         {
@@ -307,14 +404,16 @@ namespace
 
         this->isCCW = n > 0;
 
+        const TwoDVertexBuckets buckets (this->vertices);
+
         for (TwoDVertexRef v = this->begin (); v != this->end (); ++v)
         {
-          this->setIsEar (v);
+          this->setIsEar (v, buckets);
           this->setAngle (v);
         }
       }
 
-      void removeEar (TwoDVertexRef v)
+      void removeEar (TwoDVertexRef v, TwoDVertexBuckets& buckets)
       {
         assert (v->isEar);
         assert (this->size () > 3);
@@ -322,11 +421,12 @@ namespace
         TwoDVertexRef p = this->prev (v);
         TwoDVertexRef n = this->next (v);
 
+        buckets.remove (v);
         this->vertices.erase (v);
         this->setCurvature (p);
         this->setCurvature (n);
-        this->setIsEar (p);
-        this->setIsEar (n);
+        this->setIsEar (p, buckets);
+        this->setIsEar (n, buckets);
         this->setAngle (p);
         this->setAngle (n);
       }
@@ -366,6 +466,8 @@ namespace
           mesh.addFace (a->index, b->index, c->index);
         };
 
+        TwoDVertexBuckets buckets (this->vertices);
+
         while (this->size () > 3)
         {
           TwoDVertexRef earCandidate = this->end ();
@@ -382,7 +484,7 @@ namespace
           if (earCandidate != this->end ())
           {
             addFace (this->prev (earCandidate), earCandidate, this->next (earCandidate));
-            this->removeEar (earCandidate);
+            this->removeEar (earCandidate, buckets);
           }
           else
           {
@@ -404,18 +506,7 @@ namespace
 
         for (TwoDVertexCRef v0 = this->begin (); v0 != this->end (); ++v0)
         {
-          TwoDVertexCRef v1 = this->next (v0);
-          const float    v0Y = v0->position.y;
-          const float    v1Y = v1->position.y;
-
-          if (v0Y <= v.y && v.y < v1Y && isLeft (v, v0->position, v1->position))
-          {
-            windingNumber++;
-          }
-          else if (v1Y <= v.y && v.y < v0Y && isRight (v, v0->position, v1->position))
-          {
-            windingNumber--;
-          }
+          windingNumber += winding (v, v0->position, this->next (v0)->position);
         }
         return windingNumber != 0;
       }
@@ -545,45 +636,10 @@ namespace
           {
             const glm::vec2 pos = min + (glm::vec2 (float(x), float(y)) * avgLength);
             this->squares.emplace_back (glm::uvec2 (x, y), pos, avgLength);
-            TwoDSquare& square = this->squares.back ();
-
-            unsigned int numContains = 0;
-            for (const TwoDPolyline& p : ps)
-            {
-              if (p.contains (pos))
-              {
-                numContains++;
-              }
-            }
-
-            if (numContains % 2 == 1)
-            {
-              square.state = inside;
-            }
-            assert (y > 0 || square.state == outside);
-            assert (y < this->dimension.y - 1 || square.state == outside);
-            assert (x > 0 || square.state == outside);
-            assert (x < this->dimension.x - 1 || square.state == outside);
-          }
-        }
-        for (unsigned int y = 1; y < this->dimension.y - 1; y++)
-        {
-          for (unsigned int x = 1; x < this->dimension.x - 1; x++)
-          {
-            TwoDSquare& square = this->squares[this->index (x, y)];
-            if (square.state == inside)
-            {
-              for (const TwoDPolyline& p : ps)
-              {
-                if (p.intersects (square))
-                {
-                  square.state = outside;
-                  break;
-                }
-              }
-            }
           }
         }
+        this->setInsideStates (ps);
+        this->setIntersectedStates (ps);
         for (unsigned int y = 1; y < this->dimension.y - 1; y++)
         {
           for (unsigned int x = 1; x < this->dimension.x - 1; x++)
@@ -684,6 +740,150 @@ namespace
         }
       }
 
+      // x-coordinates of the squares' centers, which are the same in each row
+      std::vector<float> columnCenters () const
+      {
+        std::vector<float> centers;
+        for (unsigned int x = 0; x < this->dimension.x; x++)
+        {
+          centers.push_back (this->squares[this->index (x, 0)].center.x);
+        }
+        return centers;
+      }
+
+      // y-coordinates of the squares' centers, which are the same in each column
+      std::vector<float> rowCenters () const
+      {
+        std::vector<float> centers;
+        for (unsigned int y = 0; y < this->dimension.y; y++)
+        {
+          centers.push_back (this->squares[this->index (0, y)].center.y);
+        }
+        return centers;
+      }
+
+      /* Squares are inside if their centers are contained in an odd number of polylines.
+       * Rows are rasterized as scanlines: each row only computes winding numbers from segments that
+       * span its center, instead of testing every square against every polyline.
+       */
+      void setInsideStates (const TwoDPolylines& ps)
+      {
+        struct Segment
+        {
+          unsigned int polyline;
+          glm::vec2    from;
+          glm::vec2    to;
+        };
+
+        const std::vector<float>         rows = this->rowCenters ();
+        std::vector<std::vector<Segment>> rowSegments (this->dimension.y);
+
+        for (unsigned int i = 0; i < ps.size (); i++)
+        {
+          for (TwoDVertexCRef v = ps[i].begin (); v != ps[i].end (); ++v)
+          {
+            const glm::vec2& from = v->position;
+            const glm::vec2& to = ps[i].next (v)->position;
+
+            const auto begin =
+              std::lower_bound (rows.begin (), rows.end (), glm::min (from.y, to.y));
+            const auto end = std::lower_bound (begin, rows.end (), glm::max (from.y, to.y));
+
+            for (auto row = begin; row != end; ++row)
+            {
+              rowSegments[row - rows.begin ()].push_back (Segment{i, from, to});
+            }
+          }
+        }
+
+        for (unsigned int y = 0; y < this->dimension.y; y++)
+        {
+          const std::vector<Segment>& segments = rowSegments[y];
+
+          for (unsigned int x = 0; x < this->dimension.x; x++)
+          {
+            TwoDSquare&  square = this->squares[this->index (x, y)];
+            unsigned int numContains = 0;
+
+            // segments are grouped by polyline
+            for (unsigned int s = 0; s < segments.size ();)
+            {
+              const unsigned int polyline = segments[s].polyline;
+              int                windingNumber = 0;
+
+              for (; s < segments.size () && segments[s].polyline == polyline; s++)
+              {
+                windingNumber += winding (square.center, segments[s].from, segments[s].to);
+              }
+              if (windingNumber != 0)
+              {
+                numContains++;
+              }
+            }
+
+            if (numContains % 2 == 1)
+            {
+              square.state = TwoDSquare::State::Inside;
+            }
+            assert (y > 0 || square.state == TwoDSquare::State::Outside);
+            assert (y < this->dimension.y - 1 || square.state == TwoDSquare::State::Outside);
+            assert (x > 0 || square.state == TwoDSquare::State::Outside);
+            assert (x < this->dimension.x - 1 || square.state == TwoDSquare::State::Outside);
+          }
+        }
+      }
+
+      // inner squares that are intersected by a segment are outside. Each segment is only tested
+      // against the squares that overlap its bounding box.
+      void setIntersectedStates (const TwoDPolylines& ps)
+      {
+        assert (this->squares.empty () == false);
+
+        const std::vector<float> columns = this->columnCenters ();
+        const std::vector<float> rows = this->rowCenters ();
+        const float              margin = 2.0f * this->squares.front ().halfWidth;
+
+        // inner squares whose centers are within `margin` of [min, max]
+        const auto range = [margin](const std::vector<float>& centers, float min, float max,
+                                    unsigned int& begin, unsigned int& end) {
+          const auto lower = std::lower_bound (centers.begin (), centers.end (), min - margin);
+          const auto upper = std::upper_bound (lower, centers.end (), max + margin);
+
+          const unsigned int last = centers.size () - 1;
+
+          begin = glm::max (1u, (unsigned int) (lower - centers.begin ()));
+          end = glm::min (last, (unsigned int) (upper - centers.begin ()));
+        };
+
+        for (const TwoDPolyline& p : ps)
+        {
+          for (TwoDVertexCRef v = p.begin (); v != p.end (); ++v)
+          {
+            const glm::vec2& from = v->position;
+            const glm::vec2& to = p.next (v)->position;
+            const glm::vec2  min = glm::min (from, to);
+            const glm::vec2  max = glm::max (from, to);
+
+            unsigned int xBegin, xEnd, yBegin, yEnd;
+            range (columns, min.x, max.x, xBegin, xEnd);
+            range (rows, min.y, max.y, yBegin, yEnd);
+
+            for (unsigned int y = yBegin; y < yEnd; y++)
+            {
+              for (unsigned int x = xBegin; x < xEnd; x++)
+              {
+                TwoDSquare& square = this->squares[this->index (x, y)];
+
+                if (square.state == TwoDSquare::State::Inside && square.intersects (from, to))
+                {
+                  square.state = TwoDSquare::State::Outside;
+                }
+              }
+            }
+          }
+        }
+      }
+
       void fill (DynamicMesh& mesh) const
       {
         constexpr TwoDSquare::State out = TwoDSquare::State::Outside;
@@ -1080,22 +1280,40 @@ namespace
 
   void trimVertices (const ToolTrimMeshBorder& border)
   {
+    enum class State
+    {
+      Unknown,
+      Above,
+      NotAbove
+    };
+
+    DynamicMesh&              mesh = border.mesh ();
+    std::vector<State>        states (mesh.mesh ().numVertices (), State::Unknown);
+    std::vector<unsigned int> stack;
+    std::vector<unsigned int> trimmed;
+
     const auto isAboveBorder = [&border](unsigned int i) {
       const glm::vec3& p = border.mesh ().vertex (i);
       return border.onBorder (p) == false && border.plane ().distance (p) > 0.0f;
     };
 
-    std::unordered_set<unsigned int> set;
-    const auto addAdjacentAboveBorder = [&border, &isAboveBorder, &set](unsigned int i) {
-      border.mesh ().forEachVertexAdjacentToVertex (i, [&isAboveBorder, &set](unsigned int a) {
-        if (isAboveBorder (a))
+    const auto addAdjacentAboveBorder = [&mesh, &isAboveBorder, &states, &stack](unsigned int i) {
+      mesh.forEachVertexAdjacentToVertex (i, [&isAboveBorder, &states, &stack](unsigned int a) {
+        if (states[a] == State::Unknown)
         {
-          set.insert (a);
+          if (isAboveBorder (a))
+          {
+            states[a] = State::Above;
+            stack.push_back (a);
+          }
+          else
+          {
+            states[a] = State::NotAbove;
+          }
         }
       });
     };
 
-    DynamicMesh& mesh = border.mesh ();
     for (const ToolTrimMeshBorder::Polyline& p : border.polylines ())
     {
       for (unsigned int i : p)
@@ -1104,20 +1322,21 @@ namespace
       }
     }
 
-    while (set.empty () == false)
+    while (stack.empty () == false)
     {
-      const unsigned int i = *set.begin ();
-      set.erase (set.begin ());
+      const unsigned int i = stack.back ();
+      stack.pop_back ();
 
       addAdjacentAboveBorder (i);
-      mesh.deleteVertex (i);
+      trimmed.push_back (i);
     }
+    mesh.deleteVertices (trimmed);
   }
 }
 
 namespace ToolTrimMeshAction
 {
-  bool trimMesh (ToolTrimMeshBorder& border)
+  bool trimAndFillHole (ToolTrimMeshBorder& border)
   {
     trimVertices (border);
 
@@ -1128,7 +1347,12 @@ namespace ToolTrimMeshAction
       border.setNewIndices (newIndices);
     }
 
-    if (fillHole (border) && border.mesh ().pruneAndCheckConsistency ())
+    return fillHole (border);
+  }
+
+  bool trimMesh (ToolTrimMeshBorder& border)
+  {
+    if (trimAndFillHole (border) && border.mesh ().pruneAndCheckConsistency ())
     {
       return true;
     }
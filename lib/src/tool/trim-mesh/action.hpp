@@ -10,6 +10,9 @@ class ToolTrimMeshBorder;
 namespace ToolTrimMeshAction
 {
   bool trimMesh (ToolTrimMeshBorder&);
+
+  // like `trimMesh` but neither checks the mesh's consistency nor buffers its data
+  bool trimAndFillHole (ToolTrimMeshBorder&);
 }
 
 #endif
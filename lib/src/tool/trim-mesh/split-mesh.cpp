@@ -3,9 +3,11 @@
  * Use and redistribute under the terms of the GNU General Public License
  */
 #include <unordered_set>
+#include <vector>
 #include "dynamic/faces.hpp"
 #include "dynamic/mesh.hpp"
 #include "hash.hpp"
+#include "mesh.hpp"
 #include "primitive/plane.hpp"
 #include "primitive/ray.hpp"
 #include "tool/trim-mesh/border.hpp"
@@ -14,7 +16,38 @@
 
 namespace
 {
-  typedef std::unordered_set<unsigned int> BorderVertices;
+  // border vertices in the order of their insertion, whose positions are looked up per vertex
+  struct BorderVertices
+  {
+    std::vector<unsigned int> vertices;
+    std::vector<unsigned int> positions;
+
+    BorderVertices (const DynamicMesh& mesh)
+      : positions (mesh.mesh ().numVertices (), Util::invalidIndex ())
+    {
+    }
+
+    unsigned int size () const { return this->vertices.size (); }
+    bool         isEmpty () const { return this->vertices.empty (); }
+
+    unsigned int position (unsigned int i) const
+    {
+      return i < this->positions.size () ? this->positions[i] : Util::invalidIndex ();
+    }
+
+    void insert (unsigned int i)
+    {
+      if (i >= this->positions.size ())
+      {
+        this->positions.resize (i + 1, Util::invalidIndex ());
+      }
+      if (this->positions[i] == Util::invalidIndex ())
+      {
+        this->positions[i] = this->vertices.size ();
+        this->vertices.push_back (i);
+      }
+    }
+  };
 
   unsigned int splitEdge (DynamicMesh& mesh, unsigned int e1, unsigned e2, const glm::vec3& point)
   {
@@ -105,19 +138,28 @@ namespace
     }
   }
 
-  bool checkBorderVertices (const DynamicMesh& mesh, const BorderVertices& borderVertices)
+  // finds the positions of the two adjacent border vertices of each border vertex
+  bool findBorderNeighbors (const DynamicMesh& mesh, const BorderVertices& borderVertices,
+                            std::vector<unsigned int>& neighbors)
   {
-    for (unsigned int v : borderVertices)
+    neighbors.assign (2 * borderVertices.size (), Util::invalidIndex ());
+
+    for (unsigned int p = 0; p < borderVertices.size (); p++)
     {
       unsigned int n = 0;
-      mesh.forEachVertexAdjacentToVertex (v, [&borderVertices, &n](unsigned int a) {
-        BorderVertices::const_iterator bIt = borderVertices.find (a);
+      mesh.forEachVertexAdjacentToVertex (
+        borderVertices.vertices[p], [&borderVertices, &neighbors, p, &n](unsigned int a) {
+          const unsigned int position = borderVertices.position (a);
 
-        if (bIt != borderVertices.cend ())
-        {
-          n++;
-        }
-      });
+          if (position != Util::invalidIndex ())
+          {
+            if (n < 2)
+            {
+              neighbors[(2 * p) + n] = position;
+            }
+            n++;
+          }
+        });
       if (n != 2)
       {
         return false;
@@ -135,44 +177,37 @@ namespace
     return border.onBorder (vL) ? false : border.plane ().distance (vL) > 0.0f;
   }
 
-  void addPolylinesToBorder (ToolTrimMeshBorder& border, BorderVertices& borderVertices)
+  void addPolylinesToBorder (ToolTrimMeshBorder& border, const BorderVertices& borderVertices,
+                             const std::vector<unsigned int>& neighbors)
   {
-    BorderVertices::iterator vIt = borderVertices.end ();
+    std::vector<bool> isVisited (borderVertices.size (), false);
 
-    while (borderVertices.empty () == false)
+    for (unsigned int start = 0; start < borderVertices.size (); start++)
     {
-      if (vIt == borderVertices.end ())
+      if (isVisited[start] == false)
       {
         border.addPolyline ();
-        vIt = borderVertices.begin ();
-      }
 
-      bool foundNext = false;
+        for (unsigned int p = start; p != Util::invalidIndex ();)
+        {
+          const unsigned int v = borderVertices.vertices[p];
+          unsigned int       next = Util::invalidIndex ();
+
+          isVisited[p] = true;
+          border.addVertex (v, border.mesh ().vertex (v));
 
-      border.mesh ().forEachVertexAdjacentToVertex (
-        *vIt, [&border, &borderVertices, &vIt, &foundNext](unsigned int a) {
-          if (foundNext == false)
+          for (unsigned int n = 2 * p; n < (2 * p) + 2; n++)
           {
-            BorderVertices::iterator bIt = borderVertices.find (a);
+            const unsigned int q = neighbors[n];
 
-            if (bIt != borderVertices.end ())
+            if (isVisited[q] == false && traverseAlongEdge (border, v, borderVertices.vertices[q]))
             {
-              if (traverseAlongEdge (border, *vIt, *bIt))
-              {
-                border.addVertex (*vIt, border.mesh ().vertex (*vIt));
-                borderVertices.erase (vIt);
-                vIt = bIt;
-                foundNext = true;
-                return;
-              }
+              next = q;
+              break;
             }
           }
-        });
-      if (foundNext == false)
-      {
-        border.addVertex (*vIt, border.mesh ().vertex (*vIt));
-        borderVertices.erase (vIt);
-        vIt = borderVertices.end ();
+          p = next;
+        }
       }
     }
   }
@@ -180,16 +215,18 @@ namespace
 
 bool ToolTrimMeshSplitMesh::splitMesh (ToolTrimMeshBorder& border)
 {
-  BorderVertices borderVertices;
+  BorderVertices            borderVertices (border.mesh ());
+  std::vector<unsigned int> neighbors;
+
   ::splitMesh (border, borderVertices);
 
-  if (borderVertices.empty ())
+  if (borderVertices.isEmpty ())
   {
     return true;
   }
-  else if (checkBorderVertices (border.mesh (), borderVertices))
+  else if (findBorderNeighbors (border.mesh (), borderVertices, neighbors))
   {
-    addPolylinesToBorder (border, borderVertices);
+    addPolylinesToBorder (border, borderVertices, neighbors);
     return true;
   }
   else
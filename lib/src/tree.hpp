@@ -5,37 +5,32 @@
 #ifndef DILAY_TREE
 #define DILAY_TREE
 
-#include <list>
-#include "maybe.hpp"
+#include <deque>
+#include <memory>
+#include <vector>
 #include "util.hpp"
 
+template <typename T> class Tree;
+template <typename T> class TreeArena;
+
+/* Nodes are stored in the arena of their tree and refer to their parent, children and siblings by
+ * indices into the arena. A node keeps its address until it is deleted.
+ */
 template <typename T> class TreeNode
 {
 public:
-  TreeNode (const T& d, TreeNode* p = nullptr)
+  explicit TreeNode (const T& d)
     : _data (d)
-    , _parent (p)
   {
   }
 
-  TreeNode (T&& d, TreeNode* p = nullptr)
+  explicit TreeNode (T&& d)
     : _data (std::move (d))
-    , _parent (p)
-  {
-  }
-
-  TreeNode (const TreeNode& o)
-    : _data (o._data)
-    , _parent (nullptr)
-    , _children (o._children)
   {
-    this->forEachChild ([this](TreeNode& c) { c._parent = this; });
   }
 
-  template <typename... Args> static TreeNode make (Args&&... args)
-  {
-    return TreeNode (T (std::forward<Args> (args)...));
-  }
+  TreeNode (const TreeNode&) = delete;
+  const TreeNode& operator= (const TreeNode&) = delete;
 
   T& data () { return this->_data; }
 
@@ -43,61 +38,50 @@ public:
 
   void data (const T& d) { this->_data = d; }
 
-  TreeNode* parent () const { return this->_parent; }
+  TreeNode* parent () const { return this->node (this->_parent); }
 
   template <typename... Args> TreeNode& emplaceChild (Args&&... args)
   {
-    this->_children.emplace_back (make (std::forward<Args> (args)...));
-    this->_children.back ()._parent = this;
-
-    return this->_children.back ();
+    return this->_arena->append (T (std::forward<Args> (args)...), this->_index);
   }
 
-  TreeNode& addChild (const TreeNode& node)
-  {
-    this->_children.emplace_back (node);
-    this->_children.back ()._parent = this;
-
-    return this->_children.back ();
-  }
+  // `node` may belong to another tree
+  TreeNode& addChild (const TreeNode& node) { return this->_arena->copy (node, this->_index); }
 
   void deleteChild (TreeNode& child)
   {
-    for (auto it = this->_children.begin (); it != this->_children.end (); ++it)
-    {
-      if (&*it == &child)
-      {
-        this->_children.erase (it);
-        return;
-      }
-    }
-    DILAY_IMPOSSIBLE
+    assert (child._arena == this->_arena && child._parent == this->_index);
+    this->_arena->remove (child._index);
   }
 
-  void forEachChild (const std::function<void(TreeNode&)>& f)
+  template <typename F> void forEachChild (const F& f)
   {
-    for (TreeNode& c : this->_children)
+    for (unsigned int c = this->_firstChild; c != Util::invalidIndex ();)
     {
-      f (c);
+      TreeNode& child = *this->node (c);
+      f (child);
+      c = child._nextSibling;
     }
   }
 
-  void forEachConstChild (const std::function<void(const TreeNode&)>& f) const
+  template <typename F> void forEachConstChild (const F& f) const
   {
-    for (const TreeNode& c : this->_children)
+    for (unsigned int c = this->_firstChild; c != Util::invalidIndex ();)
     {
-      f (c);
+      const TreeNode& child = *this->node (c);
+      f (child);
+      c = child._nextSibling;
     }
   }
 
-  void forEachNode (const std::function<void(TreeNode&)>& f)
+  template <typename F> void forEachNode (const F& f)
   {
     f (*this);
 
     this->forEachChild ([&f](TreeNode& c) { c.forEachNode (f); });
   }
 
-  void forEachConstNode (const std::function<void(const TreeNode&)>& f) const
+  template <typename F> void forEachConstNode (const F& f) const
   {
     f (*this);
 
@@ -107,16 +91,16 @@ public:
   TreeNode& lastChild ()
   {
     assert (this->numChildren () > 0);
-    return this->_children.back ();
+    return *this->node (this->_lastChild);
   }
 
   const TreeNode& lastChild () const
   {
     assert (this->numChildren () > 0);
-    return this->_children.back ();
+    return *this->node (this->_lastChild);
   }
 
-  unsigned int numChildren () const { return this->_children.size (); }
+  unsigned int numChildren () const { return this->_numChildren; }
 
   unsigned int numNodes () const
   {
@@ -125,86 +109,317 @@ public:
     return n;
   }
 
-  void deleteChildIf (const std::function<bool(const TreeNode&)>& f)
+  template <typename F> void deleteChildIf (const F& f)
+  {
+    for (unsigned int c = this->_firstChild; c != Util::invalidIndex ();)
+    {
+      const TreeNode&    child = *this->node (c);
+      const unsigned int next = child._nextSibling;
+
+      if (f (child))
+      {
+        this->_arena->remove (c);
+      }
+      c = next;
+    }
+  }
+
+private:
+  friend class TreeArena<T>;
+  friend class Tree<T>;
+
+  TreeNode* node (unsigned int i) const
+  {
+    return i == Util::invalidIndex () ? nullptr : &this->_arena->nodes[i];
+  }
+
+  T             _data;
+  TreeArena<T>* _arena;
+  unsigned int  _index;
+  unsigned int  _parent;
+  unsigned int  _firstChild;
+  unsigned int  _lastChild;
+  unsigned int  _prevSibling;
+  unsigned int  _nextSibling;
+  unsigned int  _numChildren;
+};
+
+/* Storage of a tree's nodes. Nodes are appended to a deque, which keeps their addresses stable
+ * while the tree grows. Indices of deleted nodes are reused. Since nodes only refer to indices, a
+ * whole tree is copied by copying its arena front to back.
+ */
+template <typename T> class TreeArena
+{
+public:
+  TreeArena ()
+    : revision (0)
+  {
+  }
+
+private:
+  friend class TreeNode<T>;
+  friend class Tree<T>;
+
+  std::deque<TreeNode<T>>   nodes;
+  std::vector<unsigned int> freeIndices;
+  unsigned int              revision;
+
+  TreeNode<T>& append (T&& data, unsigned int parent)
   {
-    for (auto it = this->_children.begin (); it != this->_children.end ();)
+    unsigned int index;
+
+    if (this->freeIndices.empty ())
+    {
+      index = this->nodes.size ();
+      this->nodes.emplace_back (std::move (data));
+    }
+    else
+    {
+      index = this->freeIndices.back ();
+      this->freeIndices.pop_back ();
+      this->nodes[index]._data = std::move (data);
+    }
+
+    TreeNode<T>& node = this->nodes[index];
+    node._arena = this;
+    node._index = index;
+    node._parent = parent;
+    node._firstChild = Util::invalidIndex ();
+    node._lastChild = Util::invalidIndex ();
+    node._prevSibling = Util::invalidIndex ();
+    node._nextSibling = Util::invalidIndex ();
+    node._numChildren = 0;
+
+    if (parent != Util::invalidIndex ())
     {
-      if (f (*it))
+      TreeNode<T>& p = this->nodes[parent];
+
+      if (p._lastChild == Util::invalidIndex ())
       {
-        it = this->_children.erase (it);
+        p._firstChild = index;
       }
       else
       {
-        ++it;
+        this->nodes[p._lastChild]._nextSibling = index;
+        node._prevSibling = p._lastChild;
       }
+      p._lastChild = index;
+      p._numChildren++;
     }
+    this->revision++;
+    return node;
   }
 
-private:
-  T                   _data;
-  TreeNode*           _parent;
-  std::list<TreeNode> _children;
+  // copies all nodes including deleted ones, so that their indices remain valid
+  void assign (const TreeArena& source)
+  {
+    this->nodes.clear ();
+
+    for (const TreeNode<T>& s : source.nodes)
+    {
+      this->nodes.emplace_back (s._data);
+
+      TreeNode<T>& node = this->nodes.back ();
+      node._arena = this;
+      node._index = s._index;
+      node._parent = s._parent;
+      node._firstChild = s._firstChild;
+      node._lastChild = s._lastChild;
+      node._prevSibling = s._prevSibling;
+      node._nextSibling = s._nextSibling;
+      node._numChildren = s._numChildren;
+    }
+    this->freeIndices = source.freeIndices;
+    this->revision++;
+  }
+
+  TreeNode<T>& copy (const TreeNode<T>& source, unsigned int parent)
+  {
+    const TreeArena& sourceArena = *source._arena;
+
+    // the subtree is collected before copying, since `parent` may be one of its nodes
+    std::vector<ui_pair> order;  // source index, position of the parent within `order`
+    std::vector<ui_pair> stack = {ui_pair (source._index, Util::invalidIndex ())};
+
+    while (stack.empty () == false)
+    {
+      const ui_pair      item = stack.back ();
+      const unsigned int position = order.size ();
+
+      stack.pop_back ();
+      order.push_back (item);
+
+      for (unsigned int c = sourceArena.nodes[item.first]._lastChild; c != Util::invalidIndex ();
+           c = sourceArena.nodes[c]._prevSibling)
+      {
+        stack.emplace_back (c, position);
+      }
+    }
+
+    std::vector<unsigned int> copies;
+    copies.reserve (order.size ());
+
+    for (const ui_pair& item : order)
+    {
+      const unsigned int copyParent =
+        item.second == Util::invalidIndex () ? parent : copies[item.second];
+
+      copies.push_back (this->append (T (sourceArena.nodes[item.first]._data), copyParent)._index);
+    }
+    return this->nodes[copies.front ()];
+  }
+
+  void remove (unsigned int index)
+  {
+    TreeNode<T>& node = this->nodes[index];
+
+    if (node._parent != Util::invalidIndex ())
+    {
+      TreeNode<T>& p = this->nodes[node._parent];
+
+      if (node._prevSibling == Util::invalidIndex ())
+      {
+        p._firstChild = node._nextSibling;
+      }
+      else
+      {
+        this->nodes[node._prevSibling]._nextSibling = node._nextSibling;
+      }
+
+      if (node._nextSibling == Util::invalidIndex ())
+      {
+        p._lastChild = node._prevSibling;
+      }
+      else
+      {
+        this->nodes[node._nextSibling]._prevSibling = node._prevSibling;
+      }
+      p._numChildren--;
+    }
+
+    std::vector<unsigned int> stack = {index};
+    while (stack.empty () == false)
+    {
+      const unsigned int i = stack.back ();
+
+      stack.pop_back ();
+      this->freeIndices.push_back (i);
+
+      for (unsigned int c = this->nodes[i]._firstChild; c != Util::invalidIndex ();
+           c = this->nodes[c]._nextSibling)
+      {
+        stack.push_back (c);
+      }
+    }
+    this->revision++;
+  }
 };
 
 template <typename T> class Tree
 {
 public:
-  bool hasRoot () const { return bool(this->_root); }
+  Tree ()
+    : _arena (std::make_unique<TreeArena<T>> ())
+    , _root (Util::invalidIndex ())
+  {
+  }
+
+  Tree (const Tree& o)
+    : Tree ()
+  {
+    this->_arena->assign (*o._arena);
+    this->_root = o._root;
+  }
+
+  Tree (Tree&& o)
+    : Tree ()
+  {
+    this->swap (o);
+  }
+
+  const Tree& operator= (const Tree& o)
+  {
+    Tree copy (o);
+    this->swap (copy);
+    return *this;
+  }
+
+  const Tree& operator= (Tree&& o)
+  {
+    this->swap (o);
+    return *this;
+  }
+
+  bool hasRoot () const { return this->_root != Util::invalidIndex (); }
 
   TreeNode<T>& root ()
   {
     assert (this->hasRoot ());
-    return *this->_root;
+    return this->_arena->nodes[this->_root];
   }
 
   const TreeNode<T>& root () const
   {
     assert (this->hasRoot ());
-    return *this->_root;
+    return this->_arena->nodes[this->_root];
   }
 
+  // changes whenever nodes are added or deleted
+  unsigned int revision () const { return this->_arena->revision; }
+
   template <typename... Args> TreeNode<T>& emplaceRoot (Args&&... args)
   {
-    this->_root = Maybe<TreeNode<T>>::make (TreeNode<T>::make (std::forward<Args> (args)...));
-    return this->root ();
+    T data (std::forward<Args> (args)...);
+
+    this->reset ();
+    TreeNode<T>& root = this->_arena->append (std::move (data), Util::invalidIndex ());
+    this->_root = root._index;
+    return root;
   }
 
-  void reset () { this->_root.reset (); }
+  void reset ()
+  {
+    this->_arena->nodes.clear ();
+    this->_arena->freeIndices.clear ();
+    this->_arena->revision++;
+    this->_root = Util::invalidIndex ();
+  }
 
   void rebalance (TreeNode<T>& node)
   {
-    const std::function<void(const TreeNode<T>&, TreeNode<T>&)> go = [&go](const auto& child,
-                                                                           auto& rebalancedChild) {
-      if (child.parent ())
-      {
-        const auto& parent = *child.parent ();
-        auto&       rebalancedParent = rebalancedChild.emplaceChild (parent.data ());
-
-        parent.forEachConstChild ([&rebalancedParent, &child](const auto& c) {
-          if (&c != &child)
-          {
-            rebalancedParent.addChild (c);
-          }
-        });
-        go (parent, rebalancedParent);
-      }
-    };
+    Tree<T>            tree;
+    const TreeNode<T>* child = &node;
+    TreeNode<T>*       rebalancedChild = &tree._arena->copy (node, Util::invalidIndex ());
+
+    tree._root = rebalancedChild->_index;
 
-    TreeNode<T>& newRoot (node);
-    go (node, newRoot);
-    this->_root = std::move (newRoot);
+    while (child->parent ())
+    {
+      const TreeNode<T>& parent = *child->parent ();
+      TreeNode<T>&       rebalancedParent = rebalancedChild->emplaceChild (parent.data ());
+
+      parent.forEachConstChild ([&rebalancedParent, child](const TreeNode<T>& c) {
+        if (&c != child)
+        {
+          rebalancedParent.addChild (c);
+        }
+      });
+      child = &parent;
+      rebalancedChild = &rebalancedParent;
+    }
+    this->swap (tree);
   }
 
   Tree<T> split (TreeNode<T>& node)
   {
     Tree<T> tree;
-    tree._root = node;
+    tree._root = tree._arena->copy (node, Util::invalidIndex ())._index;
 
     if (node.parent ())
     {
       node.parent ()->deleteChild (node);
     }
-    else if (&node == this->_root.get ())
+    else if (this->hasRoot () && &node == &this->root ())
     {
       this->reset ();
     }
@@ -212,7 +427,14 @@ public:
   }
 
 private:
-  Maybe<TreeNode<T>> _root;
+  void swap (Tree& o)
+  {
+    std::swap (this->_arena, o._arena);
+    std::swap (this->_root, o._root);
+  }
+
+  std::unique_ptr<TreeArena<T>> _arena;
+  unsigned int                  _root;
 };
 
 #endif
@@ -226,6 +226,8 @@ namespace
                   QObject::tr ("Table pressure intensity"), Util::epsilon (), 10.0f);
 
     addBoolEdit (data, *grid, "editor/use-geometry-shader", QObject::tr ("Use geometry shader"));
+    addBoolEdit (data, *grid, "editor/show-frame-times", QObject::tr ("Show frame times"));
+    addBoolEdit (data, *grid, "editor/use-pick-buffer", QObject::tr ("Use pick buffer"));
 
     grid->addStretcher ();
 
@@ -3,10 +3,16 @@
  * Use and redistribute under the terms of the GNU General Public License
  */
 #include <QCoreApplication>
+#include <QGuiApplication>
 #include <QMouseEvent>
+#include <QOpenGLFramebufferObject>
 #include <QPainter>
+#include <QScreen>
+#include <QTimer>
+#include <chrono>
 #include <glm/glm.hpp>
 #include "camera.hpp"
+#include "color.hpp"
 #include "config.hpp"
 #include "mesh-util.hpp"
 #include "mesh.hpp"
@@ -22,16 +28,46 @@
 #include "view/info-pane/scene.hpp"
 #include "view/key-event.hpp"
 #include "view/main-window.hpp"
+#include "view/pick-buffer.hpp"
 #include "view/pointing-event.hpp"
 #include "view/tool-pane.hpp"
 #include "view/util.hpp"
 
+namespace
+{
+  typedef std::chrono::steady_clock Clock;
+
+  float millisecondsSince (const Clock::time_point& start)
+  {
+    return std::chrono::duration<float, std::milli> (Clock::now () - start).count ();
+  }
+
+  // CPU time of the passes of a frame in milliseconds
+  struct FrameTimes
+  {
+    float scene;
+    float tool;
+    float axis;
+    bool  sceneIsCached;
+
+    FrameTimes ()
+      : scene (0.0f)
+      , tool (0.0f)
+      , axis (0.0f)
+      , sceneIsCached (false)
+    {
+    }
+  };
+}
+
 struct ViewGlWidget::Impl
 {
-  typedef std::unique_ptr<ToolMoveCamera> ToolMoveCameraPtr;
-  typedef std::unique_ptr<State>          StatePtr;
-  typedef std::unique_ptr<ViewAxis>       AxisPtr;
-  typedef std::unique_ptr<ViewFloorPlane> FloorPlanePtr;
+  typedef std::unique_ptr<ToolMoveCamera>           ToolMoveCameraPtr;
+  typedef std::unique_ptr<State>                    StatePtr;
+  typedef std::unique_ptr<ViewAxis>                 AxisPtr;
+  typedef std::unique_ptr<ViewFloorPlane>           FloorPlanePtr;
+  typedef std::unique_ptr<QOpenGLFramebufferObject> FramebufferPtr;
+  typedef std::unique_ptr<ViewPickBuffer>           PickBufferPtr;
 
   ViewGlWidget*     self;
   ViewMainWindow&   mainWindow;
@@ -42,6 +78,17 @@ struct ViewGlWidget::Impl
   AxisPtr           axis;
   FloorPlanePtr     _floorPlane;
   bool              tabletPressed;
+  QTimer            frameTimer;
+  Clock::time_point lastFrame;
+  int               frameInterval;
+  bool              sceneIsDirty;
+  bool              useSceneFramebuffer;
+  FramebufferPtr    sceneFramebuffer;
+  bool              supportsPickBuffer;
+  bool              enablePickBuffer;
+  PickBufferPtr     pickBuffer;
+  bool              showFrameTimes;
+  FrameTimes        frameTimes;
 
   Impl (ViewGlWidget* s, ViewMainWindow& mW, Config& cfg, Cache& cch)
     : self (s)
@@ -49,8 +96,19 @@ struct ViewGlWidget::Impl
     , config (cfg)
     , cache (cch)
     , tabletPressed (false)
+    , frameInterval (16)
+    , sceneIsDirty (true)
+    , useSceneFramebuffer (false)
+    , supportsPickBuffer (false)
+    , enablePickBuffer (false)
+    , showFrameTimes (false)
   {
     this->self->setAutoFillBackground (false);
+
+    this->frameTimer.setSingleShot (true);
+    this->frameTimer.setTimerType (Qt::PreciseTimer);
+    QObject::connect (&this->frameTimer, &QTimer::timeout,
+                      [this]() { this->self->QOpenGLWidget::update (); });
   }
 
   ~Impl ()
@@ -60,10 +118,31 @@ struct ViewGlWidget::Impl
     this->_state.reset (nullptr);
     this->axis.reset (nullptr);
     this->_floorPlane.reset (nullptr);
+    this->sceneFramebuffer.reset (nullptr);
+    this->pickBuffer.reset (nullptr);
 
     this->self->doneCurrent ();
   }
 
+  void update ()
+  {
+    this->sceneIsDirty = true;
+    this->resetPickBuffer ();
+    this->scheduleFrame ();
+  }
+
+  void updateOverlay () { this->scheduleFrame (); }
+
+  // coalesces all requests until the next refresh of the display into a single frame
+  void scheduleFrame ()
+  {
+    if (this->frameTimer.isActive () == false)
+    {
+      const int elapsed = int(millisecondsSince (this->lastFrame));
+      this->frameTimer.start (glm::max (0, this->frameInterval - elapsed));
+    }
+  }
+
   ToolMoveCamera& immediateMoveCamera ()
   {
     assert (this->_immediateMoveCamera);
@@ -87,6 +166,28 @@ struct ViewGlWidget::Impl
     return ViewUtil::toIVec2 (this->self->mapFromGlobal (QCursor::pos ()));
   }
 
+  bool usePickBuffer () const { return this->supportsPickBuffer && this->enablePickBuffer; }
+
+  void resetPickBuffer ()
+  {
+    if (this->pickBuffer)
+    {
+      this->pickBuffer->reset ();
+    }
+  }
+
+  DynamicMesh* pick (const glm::ivec2& pos, glm::vec3& position)
+  {
+    assert (this->usePickBuffer ());
+
+    this->self->makeCurrent ();
+    DynamicMesh* mesh =
+      this->pickBuffer->pick (this->state ().camera (), this->state ().scene (), pos, position);
+    this->self->doneCurrent ();
+
+    return mesh;
+  }
+
   void fromConfig ()
   {
     assert (this->axis);
@@ -99,6 +200,10 @@ struct ViewGlWidget::Impl
     this->floorPlane ().update (this->state ().camera ());
 
     this->_immediateMoveCamera->fromConfig ();
+
+    this->showFrameTimes = this->config.get<bool> ("editor/show-frame-times");
+    this->enablePickBuffer = this->config.get<bool> ("editor/use-pick-buffer");
+    this->update ();
   }
 
   void initializeGL ()
@@ -111,6 +216,18 @@ struct ViewGlWidget::Impl
     this->_immediateMoveCamera.reset (new ToolMoveCamera (this->state (), true));
     this->_immediateMoveCamera->initialize ();
 
+    const qreal refreshRate = QGuiApplication::primaryScreen ()->refreshRate ();
+    if (refreshRate > 0.0)
+    {
+      this->frameInterval = int(1000.0 / refreshRate);
+    }
+    this->useSceneFramebuffer = QOpenGLFramebufferObject::hasOpenGLFramebufferObjects () &&
+                                QOpenGLFramebufferObject::hasOpenGLFramebufferBlit ();
+    this->supportsPickBuffer = QOpenGLFramebufferObject::hasOpenGLFramebufferObjects ();
+    this->enablePickBuffer = this->config.get<bool> ("editor/use-pick-buffer");
+    this->pickBuffer.reset (new ViewPickBuffer);
+    this->showFrameTimes = this->config.get<bool> ("editor/show-frame-times");
+
     this->self->setMouseTracking (true);
     this->self->setTabletTracking (true);
     this->initializeScene ();
@@ -135,32 +252,115 @@ struct ViewGlWidget::Impl
     this->mainWindow.infoPane ().scene ().updateInfo ();
   }
 
+  void renderScene ()
+  {
+    this->state ().camera ().renderer ().setupRendering ();
+    this->state ().scene ().render (this->state ().camera ());
+    this->floorPlane ().render (this->state ().camera ());
+  }
+
+  // returns false if the scene can not be cached in a framebuffer
+  bool renderSceneToFramebuffer ()
+  {
+    if (this->useSceneFramebuffer == false)
+    {
+      return false;
+    }
+
+    const QSize size = this->self->size () * this->self->devicePixelRatioF ();
+
+    if (this->sceneFramebuffer == nullptr || this->sceneFramebuffer->size () != size)
+    {
+      this->sceneFramebuffer.reset (
+        new QOpenGLFramebufferObject (size, QOpenGLFramebufferObject::CombinedDepthStencil));
+      this->sceneIsDirty = true;
+    }
+
+    this->frameTimes.sceneIsCached = this->sceneIsDirty == false;
+
+    if (this->sceneIsDirty)
+    {
+      this->sceneFramebuffer->bind ();
+      this->renderScene ();
+      this->sceneFramebuffer->release ();
+    }
+    return true;
+  }
+
+  void paintFrameTimes (QPainter& painter)
+  {
+    const QString text =
+      QObject::tr ("Scene: %1 ms%2, Tool: %3 ms, Axis: %4 ms")
+        .arg (this->frameTimes.scene, 0, 'f', 2)
+        .arg (this->frameTimes.sceneIsCached ? QObject::tr (" (cached)") : QString ())
+        .arg (this->frameTimes.tool, 0, 'f', 2)
+        .arg (this->frameTimes.axis, 0, 'f', 2);
+
+    painter.setPen (this->config.get<Color> ("editor/axis/color/label").qColor ());
+    painter.drawText (this->self->rect ().adjusted (5, 5, -5, -5), Qt::AlignLeft | Qt::AlignTop,
+                      text);
+  }
+
   void paintGL ()
   {
     QPainter painter (this->self);
     painter.beginNativePainting ();
 
-    this->state ().camera ().renderer ().setupRendering ();
-    this->state ().scene ().render (this->state ().camera ());
-    this->floorPlane ().render (this->state ().camera ());
+    Clock::time_point start = Clock::now ();
+
+    this->frameTimes.sceneIsCached = false;
+    if (this->renderSceneToFramebuffer ())
+    {
+      this->state ().camera ().renderer ().setupRendering ();
+      QOpenGLFramebufferObject::blitFramebuffer (nullptr, this->sceneFramebuffer.get (),
+                                                 OpenGL::ColorBufferBit () |
+                                                   OpenGL::DepthBufferBit ());
+    }
+    else
+    {
+      this->renderScene ();
+    }
+    this->sceneIsDirty = false;
+    this->frameTimes.scene = millisecondsSince (start);
 
+    start = Clock::now ();
     if (this->state ().hasTool ())
     {
       this->state ().tool ().render ();
     }
+    this->frameTimes.tool = millisecondsSince (start);
+
+    start = Clock::now ();
     this->axis->render (this->state ().camera ());
+    this->frameTimes.axis = millisecondsSince (start);
 
     this->state ().camera ().renderer ().shutdownRendering ();
     painter.endNativePainting ();
 
+    start = Clock::now ();
     this->axis->render (this->state ().camera (), painter);
+    this->frameTimes.axis += millisecondsSince (start);
+
+    start = Clock::now ();
     if (this->state ().hasTool ())
     {
       this->state ().tool ().paint (painter);
     }
+    this->frameTimes.tool += millisecondsSince (start);
+
+    if (this->showFrameTimes)
+    {
+      this->paintFrameTimes (painter);
+    }
+    this->lastFrame = Clock::now ();
   }
 
-  void resizeGL (int w, int h) { this->state ().camera ().updateResolution (glm::uvec2 (w, h)); }
+  void resizeGL (int w, int h)
+  {
+    this->state ().camera ().updateResolution (glm::uvec2 (w, h));
+    this->sceneIsDirty = true;
+    this->resetPickBuffer ();
+  }
 
   void pointingEvent (const ViewPointingEvent& e)
   {
@@ -266,7 +466,11 @@ DELEGATE (ToolMoveCamera&, ViewGlWidget, immediateMoveCamera)
 DELEGATE (State&, ViewGlWidget, state)
 DELEGATE (ViewFloorPlane&, ViewGlWidget, floorPlane)
 DELEGATE (glm::ivec2, ViewGlWidget, cursorPosition)
+DELEGATE_CONST (bool, ViewGlWidget, usePickBuffer)
+DELEGATE2 (DynamicMesh*, ViewGlWidget, pick, const glm::ivec2&, glm::vec3&)
 DELEGATE (void, ViewGlWidget, fromConfig)
+DELEGATE (void, ViewGlWidget, update)
+DELEGATE (void, ViewGlWidget, updateOverlay)
 DELEGATE (void, ViewGlWidget, initializeGL)
 DELEGATE2 (void, ViewGlWidget, resizeGL, int, int)
 DELEGATE (void, ViewGlWidget, paintGL)
@@ -11,6 +11,7 @@
 
 class Cache;
 class Config;
+class DynamicMesh;
 class State;
 class ToolMoveCamera;
 class ViewFloorPlane;
@@ -26,7 +27,11 @@ public:
   State&          state ();
   ViewFloorPlane& floorPlane ();
   glm::ivec2      cursorPosition ();
+  bool            usePickBuffer () const;
+  DynamicMesh*    pick (const glm::ivec2&, glm::vec3&);
   void            fromConfig ();
+  void            update ();
+  void            updateOverlay ();
 
 protected:
   void initializeGL ();
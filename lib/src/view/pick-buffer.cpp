@@ -0,0 +1,139 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <QOpenGLFramebufferObject>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <memory>
+#include "camera.hpp"
+#include "color.hpp"
+#include "dynamic/mesh.hpp"
+#include "opengl.hpp"
+#include "render-mode.hpp"
+#include "renderer.hpp"
+#include "scene.hpp"
+#include "view/pick-buffer.hpp"
+
+namespace
+{
+  // ids start at 1, the background has id 0
+  Color idToColor (unsigned int id)
+  {
+    assert (id > 0 && id < (1 << 24));
+    return Color (float(id & 0xff) / 255.0f, float((id >> 8) & 0xff) / 255.0f,
+                  float((id >> 16) & 0xff) / 255.0f);
+  }
+
+  unsigned int colorToId (const unsigned char* rgba)
+  {
+    return (unsigned int) (rgba[0]) | ((unsigned int) (rgba[1]) << 8) |
+           ((unsigned int) (rgba[2]) << 16);
+  }
+}
+
+struct ViewPickBuffer::Impl
+{
+  typedef std::unique_ptr<QOpenGLFramebufferObject> FramebufferPtr;
+
+  FramebufferPtr framebuffer;
+  bool           isDirty;
+
+  Impl ()
+    : isDirty (true)
+  {
+  }
+
+  void reset () { this->isDirty = true; }
+
+  void render (Camera& camera, Scene& scene)
+  {
+    const glm::uvec2& resolution = camera.resolution ();
+    const QSize       size (resolution.x, resolution.y);
+
+    if (this->framebuffer == nullptr || this->framebuffer->size () != size)
+    {
+      this->framebuffer.reset (
+        new QOpenGLFramebufferObject (size, QOpenGLFramebufferObject::Depth));
+    }
+
+    this->framebuffer->bind ();
+
+    camera.renderer ().setupRendering ();
+    OpenGL::glViewport (0, 0, resolution.x, resolution.y);
+    OpenGL::glClearColor (0.0f, 0.0f, 0.0f, 0.0f);
+    OpenGL::glClear (OpenGL::ColorBufferBit () | OpenGL::DepthBufferBit ());
+
+    unsigned int id = 0;
+    scene.forEachMesh ([&camera, &id](DynamicMesh& mesh) {
+      const RenderMode renderMode = mesh.renderMode ();
+      const Color      color = mesh.color ();
+
+      id++;
+      mesh.renderMode ().constantShading (true);
+      mesh.renderMode ().renderWireframe (false);
+      mesh.color (idToColor (id));
+      mesh.render (camera);
+
+      mesh.renderMode () = renderMode;
+      mesh.color (color);
+    });
+
+    camera.renderer ().shutdownRendering ();
+    this->framebuffer->release ();
+    this->isDirty = false;
+  }
+
+  DynamicMesh* pick (Camera& camera, Scene& scene, const glm::ivec2& pos, glm::vec3& position)
+  {
+    const glm::uvec2& resolution = camera.resolution ();
+
+    if (pos.x < 0 || pos.y < 0 || pos.x >= int(resolution.x) || pos.y >= int(resolution.y))
+    {
+      return nullptr;
+    }
+    if (this->isDirty || this->framebuffer->size () != QSize (resolution.x, resolution.y))
+    {
+      this->render (camera, scene);
+    }
+
+    const int     x = pos.x;
+    const int     y = int(resolution.y) - pos.y - 1;
+    unsigned char rgba[4];
+    float         depth;
+
+    this->framebuffer->bind ();
+    OpenGL::glReadPixels (x, y, 1, 1, OpenGL::RGBA (), OpenGL::UnsignedByte (), rgba);
+    OpenGL::glReadPixels (x, y, 1, 1, OpenGL::DepthComponent (), OpenGL::Float (), &depth);
+    this->framebuffer->release ();
+
+    const unsigned int id = colorToId (rgba);
+    DynamicMesh*       picked = nullptr;
+
+    if (id > 0)
+    {
+      unsigned int i = 0;
+      scene.forEachMesh ([id, &i, &picked](DynamicMesh& mesh) {
+        i++;
+        if (i == id)
+        {
+          picked = &mesh;
+        }
+      });
+    }
+
+    if (picked)
+    {
+      // the depth is sampled at the center of the pixel
+      const glm::vec3 window (float(x) + 0.5f, float(y) + 0.5f, depth);
+      const glm::vec4 viewport (0.0f, 0.0f, float(resolution.x), float(resolution.y));
+
+      position = glm::unProject (window, glm::mat4x4 (1.0f), camera.viewProjection (), viewport);
+    }
+    return picked;
+  }
+};
+
+DELEGATE_BIG2 (ViewPickBuffer)
+DELEGATE (void, ViewPickBuffer, reset)
+DELEGATE4 (DynamicMesh*, ViewPickBuffer, pick, Camera&, Scene&, const glm::ivec2&, glm::vec3&)
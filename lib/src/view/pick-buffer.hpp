@@ -0,0 +1,33 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_VIEW_PICK_BUFFER
+#define DILAY_VIEW_PICK_BUFFER
+
+#include <glm/fwd.hpp>
+#include "macro.hpp"
+
+class Camera;
+class DynamicMesh;
+class Scene;
+
+/* Offscreen framebuffer of the ids and depths of the dynamic meshes of a scene.
+ * The framebuffer is rendered on the first pick after `reset`, i.e. once per change of the scene
+ * or the camera, and each pick reads back a single pixel. Picking is cheaper than intersecting
+ * the scene, but is only as precise as the depth buffer.
+ * All methods require a current OpenGL context.
+ */
+class ViewPickBuffer
+{
+public:
+  DECLARE_BIG2 (ViewPickBuffer)
+
+  void         reset ();
+  DynamicMesh* pick (Camera&, Scene&, const glm::ivec2&, glm::vec3&);
+
+private:
+  IMPLEMENTATION
+};
+
+#endif
@@ -5,11 +5,14 @@
 #include <QCoreApplication>
 #include <iostream>
 #include "test-bitset.hpp"
+#include "test-bvh.hpp"
 #include "test-distance.hpp"
+#include "test-dynamic-mesh.hpp"
 #include "test-intersection.hpp"
 #include "test-maybe.hpp"
 #include "test-misc.hpp"
 #include "test-octree.hpp"
+#include "test-pick-buffer.hpp"
 #include "test-prune.hpp"
 #include "test-tree.hpp"
 
@@ -19,10 +22,12 @@ int main ()
 
   TestIntersection::test1 ();
   TestIntersection::test2 ();
+  TestIntersection::test3 ();
   TestMaybe::test1 ();
   TestMaybe::test2 ();
   TestMaybe::test3 ();
   TestOctree::test ();
+  TestDynamicMesh::test ();
   TestBitset::test ();
   TestTree::test1 ();
   TestTree::test2 ();
@@ -30,6 +35,8 @@ int main ()
   TestMisc::test ();
   TestDistance::test ();
   TestPrune::test ();
+  TestBVH::test ();
+  TestPickBuffer::test ();
 
   std::cout << "all tests ran successfully\n";
   return 0;
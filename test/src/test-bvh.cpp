@@ -0,0 +1,117 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <random>
+#include <vector>
+#include "bvh.hpp"
+#include "intersection.hpp"
+#include "primitive/aabox.hpp"
+#include "primitive/ray.hpp"
+#include "test-bvh.hpp"
+#include "util.hpp"
+
+void TestBVH::test ()
+{
+  const unsigned int numElements = 500;
+  const unsigned int numRays = 500;
+
+  std::default_random_engine            gen;
+  std::uniform_real_distribution<float> posD (-10.0f, 10.0f);
+  std::uniform_real_distribution<float> sizeD (0.01f, 2.0f);
+
+  std::vector<glm::vec3> minima, maxima;
+
+  for (unsigned int i = 0; i < numElements; i++)
+  {
+    const glm::vec3 min (posD (gen), posD (gen), posD (gen));
+
+    minima.push_back (min);
+    maxima.push_back (min + glm::vec3 (sizeD (gen), sizeD (gen), sizeD (gen)));
+  }
+
+  const auto getBounds = [&minima, &maxima](unsigned int i, glm::vec3& min, glm::vec3& max) {
+    min = minima[i];
+    max = maxima[i];
+  };
+
+  // the nearest box, where a box is hit at its entry distance
+  const auto nearestBox = [&minima, &maxima](const PrimRay& ray) {
+    float distance = Util::maxFloat ();
+    float t;
+
+    for (unsigned int i = 0; i < minima.size (); i++)
+    {
+      if (IntersectionUtil::intersects (ray, PrimAABox (minima[i], maxima[i]), &t))
+      {
+        distance = glm::min (distance, t);
+      }
+    }
+    return distance;
+  };
+
+  const auto checkRays = [&gen, &posD, &minima, &maxima, &nearestBox](const BVH& bvh) {
+    for (unsigned int r = 0; r < numRays; r++)
+    {
+      const glm::vec3 origin (posD (gen), posD (gen), posD (gen));
+      const glm::vec3 target (posD (gen), posD (gen), posD (gen));
+      const PrimRay   ray (origin, glm::normalize (target - origin));
+      float           distance = Util::maxFloat ();
+
+      bvh.intersects (ray, Util::maxFloat (),
+                      [&ray, &minima, &maxima, &distance](unsigned int i) {
+                        float t;
+                        if (IntersectionUtil::intersects (ray, PrimAABox (minima[i], maxima[i]),
+                                                          &t))
+                        {
+                          distance = glm::min (distance, t);
+                        }
+                        return distance;
+                      });
+      assert (distance == nearestBox (ray));
+      unused (distance);
+    }
+  };
+
+  const auto checkPoints = [&gen, &posD, &minima, &maxima](const BVH& bvh) {
+    for (unsigned int p = 0; p < numRays; p++)
+    {
+      const glm::vec3 point (posD (gen), posD (gen), posD (gen));
+
+      std::vector<unsigned int> expected, visited;
+
+      for (unsigned int i = 0; i < minima.size (); i++)
+      {
+        if (glm::all (glm::lessThanEqual (minima[i], point)) &&
+            glm::all (glm::lessThanEqual (point, maxima[i])))
+        {
+          expected.push_back (i);
+        }
+      }
+      bvh.intersects (point, [&visited](unsigned int i) { visited.push_back (i); });
+      std::sort (visited.begin (), visited.end ());
+      assert (visited == expected);
+    }
+  };
+
+  BVH bvh;
+  bvh.build (numElements, getBounds);
+  assert (bvh.numElements () == numElements);
+  checkRays (bvh);
+  checkPoints (bvh);
+
+  for (unsigned int i = 0; i < numElements; i++)
+  {
+    const glm::vec3 delta (posD (gen), posD (gen), posD (gen));
+
+    minima[i] += delta;
+    maxima[i] += delta;
+  }
+  bvh.refit (getBounds);
+  checkRays (bvh);
+  checkPoints (bvh);
+
+  unused (nearestBox);
+}
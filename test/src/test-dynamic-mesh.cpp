@@ -0,0 +1,68 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <glm/glm.hpp>
+#include <random>
+#include <vector>
+#include "dynamic/mesh.hpp"
+#include "intersection.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "primitive/ray.hpp"
+#include "test-dynamic-mesh.hpp"
+#include "util.hpp"
+
+void TestDynamicMesh::test ()
+{
+  // the mesh is not buffered, i.e. it is built without `fromMesh`
+  const Mesh  sphere = MeshUtil::icosphere (3);
+  DynamicMesh mesh;
+
+  for (unsigned int i = 0; i < sphere.numVertices (); i++)
+  {
+    mesh.addVertex (sphere.vertex (i), sphere.normal (i));
+  }
+  for (unsigned int i = 0; i < sphere.numIndices (); i += 3)
+  {
+    mesh.addFace (sphere.index (i), sphere.index (i + 1), sphere.index (i + 2));
+  }
+
+  std::default_random_engine            gen;
+  std::uniform_real_distribution<float> posD (-1.2f, 1.2f);
+
+  // a packet finds the same intersections per ray as rays that are intersected one by one
+  for (bool bothSides : {false, true})
+  {
+    for (unsigned int row = 0; row < 20; row++)
+    {
+      const float          y = posD (gen);
+      std::vector<PrimRay> rays;
+
+      for (unsigned int i = 0; i < 50; i++)
+      {
+        rays.emplace_back (glm::vec3 (posD (gen), y, -2.0f), glm::vec3 (0.0f, 0.0f, 1.0f));
+      }
+
+      std::vector<std::vector<Intersection>> packetIntersections;
+      mesh.intersectsAll (rays, packetIntersections, bothSides);
+      assert (packetIntersections.size () == rays.size ());
+
+      for (unsigned int r = 0; r < rays.size (); r++)
+      {
+        std::vector<Intersection> intersections;
+        const bool isIntersection = mesh.intersectsAll (rays[r], intersections, bothSides);
+
+        assert (isIntersection == (intersections.empty () == false));
+        assert (intersections.size () == packetIntersections[r].size ());
+
+        for (unsigned int i = 0; i < intersections.size (); i++)
+        {
+          assert (intersections[i].distance () == packetIntersections[r][i].distance ());
+          assert (intersections[i].position () == packetIntersections[r][i].position ());
+        }
+        unused (isIntersection);
+      }
+    }
+  }
+}
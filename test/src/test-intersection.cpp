@@ -3,13 +3,19 @@
  * Use and redistribute under the terms of the GNU General Public License
  */
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
 #include "intersection.hpp"
 #include "primitive/aabox.hpp"
 #include "primitive/cone.hpp"
 #include "primitive/cylinder.hpp"
+#include "primitive/frustum.hpp"
 #include "primitive/plane.hpp"
 #include "primitive/ray.hpp"
 #include "primitive/sphere.hpp"
+#include "primitive/triangle-packet.hpp"
 #include "primitive/triangle.hpp"
 #include "test-intersection.hpp"
 #include "util.hpp"
@@ -97,6 +103,20 @@ void TestIntersection::test1 ()
   assert (intersects (cne, glm::vec3 (1.0f, 0.0f, 0.0f)));
   assert (intersects (cne, glm::vec3 (0.5f, 1.0f, 0.0f)));
   assert (intersects (cne, glm::vec3 (0.8f, 0.1f, 0.0f)));
+
+  const glm::mat4x4 prj = glm::perspective (glm::half_pi<float> (), 1.0f, 0.1f, 10.0f);
+  const glm::mat4x4 vw =
+    glm::lookAt (glm::vec3 (0.0f, 0.0f, 5.0f), glm::vec3 (0.0f), glm::vec3 (0.0f, 1.0f, 0.0f));
+  const glm::mat4x4 trn = glm::translate (glm::mat4x4 (1.0f), glm::vec3 (20.0f, 0.0f, 0.0f));
+  const PrimFrustum frs (prj * vw);
+
+  assert (intersects (frs, abx));
+  assert (intersects (frs, PrimAABox (glm::vec3 (4.5f, 0.0f, 0.0f), 1.0f)));
+  assert (intersects (frs, PrimAABox (glm::vec3 (20.0f, 0.0f, 0.0f), 1.0f)) == false);
+  assert (intersects (frs, PrimAABox (glm::vec3 (0.0f, 0.0f, 6.0f), 1.0f)) == false);
+  assert (intersects (frs, PrimAABox (glm::vec3 (0.0f, 0.0f, -10.0f), 1.0f)) == false);
+  assert (intersects (frs.transform (trn), abx) == false);
+  assert (intersects (frs.transform (trn), PrimAABox (glm::vec3 (-20.0f, 0.0f, 0.0f), 1.0f)));
   unused (t);
 }
 
@@ -117,3 +137,44 @@ void TestIntersection::test2 ()
   assert (i2.position () == glm::vec3 (2.0f));
   assert (i2.normal () == glm::vec3 (2.0f));
 }
+
+void TestIntersection::test3 ()
+{
+  std::default_random_engine            gen;
+  std::uniform_real_distribution<float> posD (-2.0f, 2.0f);
+  std::uniform_real_distribution<float> sizeD (0.1f, 1.5f);
+  std::uniform_int_distribution<int>    numD (1, PrimTrianglePacket::maxSize);
+
+  const auto randomVec = [&gen, &posD]() { return glm::vec3 (posD (gen), posD (gen), posD (gen)); };
+
+  for (unsigned int n = 0; n < 1000; n++)
+  {
+    const unsigned int     numTriangles = numD (gen);
+    std::vector<glm::vec3> vertices;
+    PrimTrianglePacket     packet;
+
+    for (unsigned int i = 0; i < numTriangles; i++)
+    {
+      vertices.push_back (randomVec ());
+      vertices.push_back (randomVec ());
+      vertices.push_back (randomVec ());
+      packet.add (vertices[(3 * i) + 0], vertices[(3 * i) + 1], vertices[(3 * i) + 2]);
+    }
+
+    const PrimSphere sphere (randomVec (), sizeD (gen));
+    const PrimAABox  box (randomVec (), sizeD (gen), sizeD (gen), sizeD (gen));
+
+    unsigned int sphereHits = 0;
+    unsigned int boxHits = 0;
+
+    for (unsigned int i = 0; i < numTriangles; i++)
+    {
+      const PrimTriangle tri (vertices[(3 * i) + 0], vertices[(3 * i) + 1], vertices[(3 * i) + 2]);
+
+      sphereHits |= unsigned(IntersectionUtil::intersects (sphere, tri)) << i;
+      boxHits |= unsigned(IntersectionUtil::intersects (box, tri)) << i;
+    }
+    assert (IntersectionUtil::intersects (sphere, packet) == sphereHits);
+    assert (IntersectionUtil::intersects (box, packet) == boxHits);
+  }
+}
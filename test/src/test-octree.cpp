@@ -6,9 +6,13 @@
 #include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <random>
+#include <set>
+#include <vector>
 #include "dynamic/octree.hpp"
+#include "primitive/ray.hpp"
 #include "primitive/triangle.hpp"
 #include "test-octree.hpp"
+#include "util.hpp"
 
 void TestOctree::test ()
 {
@@ -47,6 +51,33 @@ void TestOctree::test ()
 
     octree.addElement (i, tri.center (), tri.maxDimExtent ());
   }
+
+  // a packet visits the same elements per ray as rays that are intersected one by one
+  std::vector<PrimRay> rays;
+  for (unsigned int i = 0; i < 100; i++)
+  {
+    rays.emplace_back (glm::vec3 (posD (gen), posD (gen), -20.0f), glm::vec3 (0.0f, 0.0f, 1.0f));
+  }
+
+  std::vector<std::set<unsigned int>> packetElements (rays.size ());
+  octree.intersects (rays, [&packetElements](const std::vector<unsigned int>& active,
+                                             unsigned int                     i) {
+    for (unsigned int r : active)
+    {
+      packetElements[r].insert (i);
+    }
+  });
+
+  for (unsigned int r = 0; r < rays.size (); r++)
+  {
+    std::set<unsigned int> elements;
+    octree.intersects (rays[r], [&elements](unsigned int i) {
+      elements.insert (i);
+      return Util::maxFloat ();
+    });
+    assert (elements == packetElements[r]);
+  }
+
   for (unsigned int i = 0; i < numSamples; i++)
   {
     octree.deleteElement (i);
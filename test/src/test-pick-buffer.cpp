@@ -0,0 +1,124 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include "camera.hpp"
+#include "config.hpp"
+#include "dynamic/mesh-intersection.hpp"
+#include "dynamic/mesh.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "opengl.hpp"
+#include "primitive/ray.hpp"
+#include "scene.hpp"
+#include "test-pick-buffer.hpp"
+#include "util.hpp"
+#include "view/pick-buffer.hpp"
+
+/* Compares picks of `ViewPickBuffer` with the scene intersections `Tool::intersectsScene` is
+ * based on. The test renders offscreen, so that it also runs without a display when Qt's
+ * offscreen platform can provide a context, e.g. with Mesa's software rasteriser:
+ *
+ *   QT_QPA_PLATFORM=offscreen LIBGL_ALWAYS_SOFTWARE=1 ./run-tests
+ *
+ * The test is skipped if no OpenGL context can be created.
+ */
+void TestPickBuffer::test ()
+{
+  const glm::uvec2 resolution (160, 120);
+
+  if (qEnvironmentVariableIsEmpty ("QT_QPA_PLATFORM") && qEnvironmentVariableIsEmpty ("DISPLAY"))
+  {
+    qputenv ("QT_QPA_PLATFORM", "offscreen");
+  }
+
+  int   argc = 1;
+  char  arg0[] = "run-tests";
+  char* argv[] = {arg0, nullptr};
+
+  QGuiApplication app (argc, argv);
+
+  OpenGL::setDefaultFormat ();
+
+  QOffscreenSurface surface;
+  surface.setFormat (QSurfaceFormat::defaultFormat ());
+  surface.create ();
+
+  QOpenGLContext context;
+  context.setFormat (QSurfaceFormat::defaultFormat ());
+
+  if (context.create () == false || context.makeCurrent (&surface) == false)
+  {
+    std::cout << "skipping TestPickBuffer: could not create an OpenGL context\n";
+    return;
+  }
+  OpenGL::initializeFunctions (false);
+
+  {
+    Config config;
+    Camera camera (config);
+    Scene  scene (config);
+
+    camera.updateResolution (resolution);
+    camera.set (glm::vec3 (0.0f), glm::vec3 (0.0f, 1.0f, 6.0f));
+
+    // two spheres side by side and one that is partially hidden behind them
+    const glm::vec3 positions[] = {glm::vec3 (-1.1f, 0.0f, 0.0f), glm::vec3 (1.1f, 0.0f, 0.0f),
+                                   glm::vec3 (0.0f, 1.0f, -2.5f)};
+    for (const glm::vec3& p : positions)
+    {
+      Mesh mesh = MeshUtil::icosphere (4);
+      mesh.position (p);
+      mesh.normalize ();
+      scene.newDynamicMesh (config, mesh);
+    }
+
+    ViewPickBuffer  pickBuffer;
+    const glm::vec4 viewport (0.0f, 0.0f, float(resolution.x), float(resolution.y));
+    unsigned int    numHits = 0;
+    unsigned int    numMismatches = 0;
+
+    for (unsigned int y = 0; y < resolution.y; y += 3)
+    {
+      for (unsigned int x = 0; x < resolution.x; x += 3)
+      {
+        // the pick buffer samples the center of a pixel, so the ray passes through it too
+        const glm::vec3 center (float(x) + 0.5f, float(resolution.y - y) - 0.5f, 0.0f);
+        const glm::vec3 onNearPlane =
+          glm::unProject (center, glm::mat4x4 (1.0f), camera.viewProjection (), viewport);
+        const PrimRay ray (camera.position (), onNearPlane - camera.position ());
+
+        DynamicMeshIntersection intersection;
+        glm::vec3               position;
+
+        const bool isIntersection = scene.intersects (ray, intersection);
+        const DynamicMesh* picked = pickBuffer.pick (camera, scene, glm::ivec2 (x, y), position);
+
+        if (isIntersection && picked)
+        {
+          numHits++;
+          if (picked != &intersection.mesh () ||
+              glm::distance (position, intersection.position ()) > 0.01f)
+          {
+            numMismatches++;
+          }
+        }
+        else if (isIntersection || picked)
+        {
+          numMismatches++;
+        }
+      }
+    }
+    assert (numHits > 0);
+    assert (numMismatches == 0);
+    unused (numHits);
+    unused (numMismatches);
+  }
+  context.doneCurrent ();
+}
@@ -9,21 +9,27 @@ INCLUDEPATH    += src $$PWD/../lib/src
 SOURCES += \
            src/main.cpp \
            src/test-bitset.cpp \
+           src/test-bvh.cpp \
            src/test-distance.cpp \
+           src/test-dynamic-mesh.cpp \
            src/test-intersection.cpp \
            src/test-maybe.cpp \
            src/test-misc.cpp \
            src/test-octree.cpp \
+           src/test-pick-buffer.cpp \
            src/test-prune.cpp \
            src/test-tree.cpp
 
 HEADERS += \
            src/test-bitset.hpp \
+           src/test-bvh.hpp \
            src/test-distance.hpp \
+           src/test-dynamic-mesh.hpp \
            src/test-intersection.hpp \
            src/test-maybe.hpp \
            src/test-misc.hpp \
            src/test-octree.hpp \
+           src/test-pick-buffer.hpp \
            src/test-prune.hpp \
            src/test-tree.hpp
 